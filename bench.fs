@@ -0,0 +1,292 @@
+\ statistical benchmark runner
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ Unlike onebench.fs, which takes one sample of each benchmark, this
+\ runs each benchmark a few times for warmup and then measures a
+\ number of runs.  It reports the median, the median absolute
+\ deviation (MAD) and a distribution-free 95% confidence interval of
+\ the median (all in microseconds of CPU time, or of wall-clock time
+\ for benchmarks that wait or start processes).
+
+\ Each result is appended as one JSON object per line (JSON Lines) to
+\ the file named by $GFORTH_BENCH_JSON (default: bench.json), so the
+\ runs of several engines can be collected in one file.  If
+\ $GFORTH_BENCH_BASELINE names such a file from an earlier run, each
+\ result is compared with the baseline result of the same engine and
+\ benchmark; a result is a regression if even the lower end of its
+\ confidence interval is more than bench-threshold percent slower than
+\ the baseline median.
+
+\ Usage: gforth-fast bench.fs -e "s\" gforth-fast\" bench-all bench-bye"
+\ or, for one workload of your own:
+\ gforth-fast bench.fs -e "s\" gforth-fast\" s\" work.fs\" bench-file bench-bye"
+\ A benchmark file may also define bench-cleanup, which is executed
+\ after the measurements, e.g., to close files or stop tasks that
+\ main uses.
+
+warnings off
+
+\ load here, not in a benchmark: its definitions would be forgotten
+\ after the benchmark, while its hooks stay in place
+require unix/pthread.fs
+require trace.fs
+
+3 Value bench-warmup    \ unmeasured runs per benchmark
+#11 Value bench-runs    \ measured runs per benchmark
+5 Value bench-threshold \ regression threshold in percent
+
+$Variable bench-engine  \ label of the engine under test
+$Variable bench-names   \ $[] of benchmark names
+$Variable bench-files   \ $[] of the files defining them
+$Variable bench-baseline \ $[] of lines of the baseline file
+Variable bench-regressions
+
+: benchmark ( "name" "file" -- )
+    \ register file, which defines main, as benchmark name
+    parse-name bench-names $+[]!  parse-name bench-files $+[]! ;
+
+benchmark sieve  siev.fs
+benchmark bubble bubble.fs
+benchmark matrix matrix.fs
+benchmark fib    fib.fs
+benchmark fft    fft-bench.fs
+benchmark interpret      bench/interpret.fs
+benchmark compile        bench/compile.fs
+benchmark evaluate       bench/evaluate.fs
+benchmark find-name      bench/find-name-in.fs
+benchmark find-name-miss bench/find-name-in2.fs
+benchmark hash-find      bench/hash-find.fs
+benchmark hash-find-miss bench/hash-find2.fs
+benchmark strings        bench/strings.fs
+benchmark read-line      bench/read-line.fs
+benchmark exceptions     bench/exceptions.fs
+benchmark closures       bench/closures.fs
+benchmark send-event     bench/send-event.fs
+benchmark startup        bench/startup.fs
+benchmark image-load     bench/image-load.fs
+
+\ the clock: CPU time by default; benchmarks that wait or start
+\ processes switch to wall-clock time with ' wall-clock is bench-clock
+
+: cpu-clock ( -- dus )  cputime d+ ;
+: wall-clock ( -- dus )  utime ;
+Defer bench-clock ( -- dus )
+' cpu-clock is bench-clock
+
+\ hooks for hardware counters
+
+Defer bench-measure ( xt -- )
+\ execute xt, measuring hardware counters if available
+' execute is bench-measure
+Defer .bench-counters ( -- )
+\ append the counters of the last bench-measure as JSON members
+' noop is .bench-counters
+
+\ samples and statistics
+
+0 Value samples  \ cell array of bench-runs samples
+0 Value devs     \ scratch array for the MAD
+
+: sort-cells ( addr u -- )
+    \ insertion sort, the arrays are short
+    cells over + { a e }
+    a cell+ BEGIN  dup e u<  WHILE
+	    dup @ over BEGIN  dup a u>  WHILE
+		    2dup cell- @ u< WHILE
+			dup cell- @ over !  cell-
+		REPEAT  THEN
+	    !  cell+
+    REPEAT  drop ;
+
+: median ( addr u -- n )
+    \ median of the sorted array
+    2 /mod cells rot + swap IF  @  EXIT  THEN
+    dup cell- @ swap @ + 2/ ;
+
+: median-ci ( -- lo hi )
+    \ ranks n/2-0.98sqrt(n) and n/2+1+0.98sqrt(n) (1-based) of the
+    \ sorted samples; the median is between them with 95% probability
+    bench-runs s>f fsqrt 0.98e f* bench-runs s>f 2e f/
+    fover fover fswap f- floor f>s 1 max
+    f+ 1e f+ fceil f>s bench-runs min
+    swap 1- cells samples + @  swap 1- cells samples + @ ;
+
+: mad ( med -- u )
+    bench-runs 0 ?DO
+	samples I cells + @ over - abs devs I cells + !
+    LOOP  drop
+    devs bench-runs 2dup sort-cells median ;
+
+: sample ( xt -- u )
+    \ time in us of one execution of xt
+    bench-clock 2>r  bench-measure  bench-clock 2r> d- d>s ;
+
+: measure ( xt -- )
+    bench-warmup 0 ?DO  dup execute  LOOP
+    bench-runs 0 ?DO  dup sample samples I cells + !  LOOP  drop
+    samples bench-runs sort-cells ;
+
+\ JSON output (.json-string is in trace.fs)
+
+: .json-name ( c-addr u -- )
+    .json-string ':' emit ;
+
+: .json-u ( c-addr u n -- )
+    \ member c-addr u with value n
+    -rot .json-name  0 .r ;
+
+\ with $GFORTH_BENCH_COUNTERS set, count with the hardware counters
+\ of unix/perf.fs (Linux)
+
+s" GFORTH_BENCH_COUNTERS" getenv nip [IF]
+    require unix/perf.fs
+    ' counters-execute is bench-measure
+    :noname ( -- )
+	#counters 0 ?DO
+	    ',' emit  I counter-name I counter@ .json-u
+	LOOP ; is .bench-counters
+[THEN]
+
+: .bench-json ( c-addr u -- )
+    \ result of benchmark c-addr u as JSON object on one line
+    '{' emit
+    s" engine" .json-name  bench-engine $@ .json-string  ',' emit
+    s" benchmark" .json-name  .json-string  ',' emit
+    s" unit" .json-name  s" us" .json-string  ',' emit
+    s" clock" .json-name  action-of bench-clock ['] wall-clock =
+    IF  s" wall"  ELSE  s" cpu"  THEN  .json-string  ',' emit
+    s" runs" bench-runs .json-u  ',' emit
+    s" median" samples bench-runs median dup >r .json-u  ',' emit
+    s" mad" r> mad .json-u  ',' emit
+    s" ci95" .json-name  median-ci  '[' emit swap 0 .r ',' emit 0 .r ']' emit
+    ',' emit
+    s" samples" .json-name  '[' emit
+    bench-runs 0 ?DO
+	I IF  ',' emit  THEN  samples I cells + @ 0 .r
+    LOOP  ']' emit
+    .bench-counters
+    '}' emit cr ;
+
+: bench-json-file ( -- c-addr u )
+    s" GFORTH_BENCH_JSON" getenv dup 0= IF  2drop s" bench.json"  THEN ;
+
+: append-json ( c-addr u -- )
+    bench-json-file 2dup w/o open-file IF
+	drop w/o create-file throw
+    ELSE  nip nip  THEN  >r
+    r@ file-size throw r@ reposition-file throw
+    ['] .bench-json r@ outfile-execute
+    r> close-file throw ;
+
+\ baseline comparison
+
+: load-baseline ( -- )
+    bench-baseline $[]free
+    s" GFORTH_BENCH_BASELINE" getenv dup IF
+	bench-baseline $[]slurp-file
+    ELSE  2drop  THEN ;
+
+: json-member? ( c-addr1 u1 c-addr2 u2 c-addr3 u3 -- f )
+    \ does line c-addr1 u1 contain "c-addr2":"c-addr3"?
+    [: '"' emit 2swap type s\" \":\"" type type '"' emit ;] >string-execute
+    2dup 2>r search nip nip 2r> drop free throw ;
+
+: json-number ( c-addr1 u1 c-addr2 u2 -- u true | false )
+    \ the number in member c-addr2 u2 of line c-addr1 u1
+    [: '"' emit type s\" \":" type ;] >string-execute
+    2dup 2>r search IF
+	2r@ nip /string 0. 2swap >number 2drop drop true
+    ELSE  2drop false  THEN
+    2r> drop free throw ;
+
+: line-median ( c-addr1 u1 c-addr2 u2 -- u true | false )
+    \ the median in line c-addr2 u2 if it is the result of benchmark
+    \ c-addr1 u1 and the current engine
+    { d: name d: line }
+    line s" engine" bench-engine $@ json-member?
+    line s" benchmark" name json-member? and IF
+	line s" median" json-number  EXIT  THEN
+    false ;
+
+: baseline-median ( c-addr u -- u true | false )
+    bench-baseline $[]# 0 ?DO
+	2dup I bench-baseline $[]@ line-median IF
+	    2swap 2drop true UNLOOP EXIT  THEN
+    LOOP  2drop false ;
+
+: .percent ( n -- )
+    \ n is in tenths of a percent
+    dup 0>= IF  '+' emit  THEN
+    s>d tuck dabs <<# # '.' hold #s rot sign #> type #>> '%' emit ;
+
+: compare-baseline ( c-addr u -- )
+    baseline-median 0= IF  EXIT  THEN  { base }
+    base 0= IF  EXIT  THEN
+    samples bench-runs median base - #1000 base */ space .percent
+    median-ci drop #100 * base #100 bench-threshold + * > IF
+	."  REGRESSION"  1 bench-regressions +!
+    THEN ;
+
+\ running
+
+: .us ( u -- )
+    \ as ms with three decimals, right-aligned
+    0 <<# # # # '.' hold #s #> 9 over - spaces type #>> ;
+
+: .bench ( c-addr u -- )
+    2dup type #15 over - 0 max spaces
+    samples bench-runs median dup .us
+    ."  ms +-" mad .us
+    ."  95%:" median-ci swap .us ."  .." .us
+    compare-baseline ;
+
+: run-benchmark ( c-addr-name u-name c-addr-file u-file -- )
+    s" marker bench-marker" evaluate
+    ['] cpu-clock is bench-clock  included  s" main" find-name name>interpret measure
+    s" bench-cleanup" find-name ?dup-IF  name>interpret execute  THEN
+    s" bench-marker" evaluate
+    2dup .bench cr  append-json ;
+
+: bench-init ( c-addr u -- )
+    \ label the results with engine c-addr u
+    bench-engine $!  bench-regressions off  load-baseline
+    samples free throw  devs free throw
+    bench-runs cells allocate throw to samples
+    bench-runs cells allocate throw to devs
+    ." engine: " bench-engine $@ type cr ;
+
+: bench-file ( c-addr1 u1 c-addr2 u2 -- )
+    \ run the file c-addr2 u2, which defines main, as benchmark,
+    \ labeling the result with engine c-addr1 u1
+    2swap bench-init  2dup run-benchmark ;
+
+: bench-all ( c-addr u -- )
+    \ run all benchmarks, labeling the results with engine c-addr u
+    bench-init
+    bench-names $[]# 0 ?DO
+	I bench-names $[]@  I bench-files $[]@  run-benchmark
+    LOOP ;
+
+: bench-bye ( -- )
+    \ leave gforth, with exit code 1 if there were regressions
+    bench-regressions @ IF
+	bench-regressions @ . ." regression(s)" cr
+	obuf-flush 1 (bye)  THEN
+    bye ;
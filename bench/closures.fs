@@ -0,0 +1,14 @@
+\ Benchmark for closures
+
+\ 1 million heap closures and 1 million locals-stack closures, each
+\ created and executed once; run with bench.fs, or with
+\ gforth-fast bench/closures.fs -e "main bye"
+
+: heap-closure ( n -- n' )
+    [{: n :}h n 1+ ;] dup execute swap >addr free throw ;
+
+: locals-closure ( n -- n' )
+    [{: n :}l n 1+ ;] execute ;
+
+: main ( -- )
+    0 1000000 0 DO  heap-closure locals-closure  LOOP  drop ;
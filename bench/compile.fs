@@ -0,0 +1,16 @@
+\ Benchmark for the compiler
+
+\ 20000 colon definitions with control structures and literals,
+\ forgotten every 200 definitions; run with bench.fs, or with
+\ gforth-fast bench/compile.fs -e "main bye"
+
+: definition ( -- c-addr u )
+    s" : bench-word ( n -- n' ) dup 0< IF negate THEN 1+ 3 0 DO dup + LOOP 7 and 'x' over = drop ;" ;
+
+: compile-some ( -- )
+    marker, 200 0 DO  definition evaluate  LOOP  marker! ;
+
+: main ( -- )
+    warnings @ warnings off
+    100 0 DO  compile-some  LOOP
+    warnings ! ;
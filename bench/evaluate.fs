@@ -0,0 +1,8 @@
+\ Benchmark for evaluate
+
+\ 1 million evaluations of a short string, i.e., mostly the cost of
+\ saving and restoring the input source; run with bench.fs, or with
+\ gforth-fast bench/evaluate.fs -e "main bye"
+
+: main ( -- )
+    1000000 0 DO  s" 1" evaluate drop  LOOP ;
@@ -32,4 +32,7 @@
         ['] bench-nt forth-wordlist traverse-wordlist
     dup 0= until ;
 
-10000000 bench bye
+: main ( -- ) \ one million searches, for bench.fs
+    1000000 bench ;
+
+[defined] bench-all 0= [IF] 10000000 bench bye [THEN]
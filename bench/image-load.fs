@@ -0,0 +1,20 @@
+\ Benchmark for image loading
+
+\ starts the engine running this benchmark 20 times with the kernel
+\ image only, without the boot code of the full image; compared with
+\ the startup benchmark, this shows how much loading the larger image
+\ costs.  Run with bench.fs.
+
+[defined] wall-clock [IF] ' wall-clock is bench-clock [THEN]
+
+: .kernel-image ( -- )
+    \ kernl<bits><byte order>.fi, as built by make
+    ." kernl" cell 8 * 0 .r  1 sp@ c@ nip IF  'l'  ELSE  'b'  THEN  emit
+    ." .fi" ;
+
+: image-load-command ( -- c-addr u )
+    [: 0 arg type ."  --no-0rc -i " .kernel-image ."  -e bye" ;]
+    >string-execute ;
+
+: main ( -- )
+    image-load-command 20 0 DO  2dup system  LOOP  drop free throw ;
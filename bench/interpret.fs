@@ -0,0 +1,11 @@
+\ Benchmark for the text interpreter
+
+\ 100000 interpretations of a line with numbers in various notations
+\ and words from the forth-wordlist; run with bench.fs, or with
+\ gforth-fast bench/interpret.fs -e "main bye"
+
+: interpret-line ( -- c-addr u )
+    s" 1 2 + 3 * dup 4 swap - negate abs over max min drop 5. d>s $10 %101 #7 'a' + + + + drop" ;
+
+: main ( -- )
+    100000 0 DO  interpret-line evaluate  LOOP ;
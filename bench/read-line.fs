@@ -0,0 +1,26 @@
+\ Benchmark for read-line
+
+\ reads a file of 10000 lines 20 times; run with bench.fs, or with
+\ gforth-fast bench/read-line.fs -e "main bye"
+
+s" bench-read-line.tmp" r/w create-file throw Value lines-fid
+: write-lines ( -- )
+    10000 0 DO
+	s" a line of text of moderate length, with a number: " lines-fid write-file throw
+	I 0 <# #s #> lines-fid write-line throw
+    LOOP ;
+write-lines
+\ the file disappears when lines-fid is closed (on Unix)
+s" bench-read-line.tmp" delete-file drop
+
+Create line-buffer 256 allot
+
+: read-lines ( -- )
+    0. lines-fid reposition-file throw
+    BEGIN  line-buffer 256 lines-fid read-line throw  WHILE  drop  REPEAT
+    drop ;
+
+: main ( -- )
+    20 0 DO  read-lines  LOOP ;
+
+: bench-cleanup ( -- )  lines-fid close-file throw ;
@@ -0,0 +1,16 @@
+\ Benchmark for pthread events
+
+\ 20000 round trips of send-event to another task and back
+\ (with event-block); run with bench.fs, or with
+\ gforth-fast bench/send-event.fs -e "main bye"
+\ uses wall-clock time, because most of the time is spent waiting
+
+require unix/pthread.fs
+
+' event-loop execute-task Value worker
+[defined] wall-clock [IF] ' wall-clock is bench-clock [THEN]
+
+: main ( -- )
+    20000 0 DO  worker event-block  LOOP ;
+
+: bench-cleanup ( -- )  [: kill-task ;] worker send-event ;
@@ -0,0 +1,13 @@
+\ Benchmark for startup time
+
+\ starts the engine running this benchmark 20 times with the default
+\ image, and leaves it immediately; this measures loading and
+\ relocating the image and initializing the system.  Run with bench.fs.
+
+[defined] wall-clock [IF] ' wall-clock is bench-clock [THEN]
+
+: startup-command ( -- c-addr u )
+    [: 0 arg type ."  --no-0rc -e bye" ;] >string-execute ;
+
+: main ( -- )
+    startup-command 20 0 DO  2dup system  LOOP  drop free throw ;
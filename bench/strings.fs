@@ -0,0 +1,17 @@
+\ Benchmark for $-strings
+
+\ builds 10000 strings of 100 pieces each with $+!, copies and
+\ frees them; run with bench.fs, or with
+\ gforth-fast bench/strings.fs -e "main bye"
+
+$Variable bench$
+$Variable copy$
+
+: build ( -- )
+    s" start" bench$ $!
+    100 0 DO  s" , piece" bench$ $+!  I 0 <# #s #> bench$ $+!  LOOP
+    bench$ $@ copy$ $!  s" end" copy$ $+!
+    bench$ $free  copy$ $free ;
+
+: main ( -- )
+    10000 0 DO  build  LOOP ;
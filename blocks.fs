@@ -19,11 +19,13 @@
 \ along with this program. If not, see http://www.gnu.org/licenses/.
 
 
-\ A more efficient implementation would use mmap on OSs that
-\ provide it and many buffers on OSs that do not provide mmap.
+\ Block buffers are managed as a pool of BUFFERS buffers; a hash
+\ table indexed by (fid, block) finds the buffer assigned to a block,
+\ and the CLOCK algorithm (an approximation of LRU) selects the victim
+\ buffer on a miss.  Sequential misses read ahead READ-AHEAD blocks.
 
-\ Now, the replacement algorithm is "direct mapped"; change to LRU
-\ if too slow. Using more buffers helps, too.
+\ On OSs with mmap, unix/blocks-mmap.fs maps the blocks file directly
+\ instead of copying it into buffers.
 
 \ I think I avoid the assumption 1 char = 1 here, but I have not tested this
 
@@ -35,14 +37,25 @@ struct
     cell%		field buffer-block   \ the block number
     cell%		field buffer-fid     \ the block's fid
     cell%		field buffer-dirty   \ the block dirty flag
+    cell%		field buffer-ref     \ the block referenced flag (CLOCK)
+    cell%		field buffer-chain   \ next buffer in the hash bucket
     char% chars/block * field block-buffer   \ the data
     cell% 0 *		field next-buffer
 end-struct buffer-struct
 
 Variable block-buffers
+Variable block-hash
+Variable block-hash-mask
+Variable block-hand \ the clock hand: index of the next victim candidate
 Variable last-block
+Variable last-miss  \ the last block read on a buffer miss
 
-$20 Value buffers
+$40 Value buffers ( -- u ) \ gforth
+\G Number of block buffers; change it with @code{set-buffers}.
+
+4 Value read-ahead ( -- u ) \ gforth
+\G Number of blocks read when @code{block} misses on the block
+\G following the previously read one; 1 disables read-ahead.
 
 \ limit block files to 2GB; gforth <0.6.0 erases larger block files on
 \ 32-bit systems
@@ -59,18 +72,25 @@ User block-offset ( -- addr ) \ gforth
 
 ' block-offset alias offset \ !! eliminate this?
 
+: block-hash-size ( -- u )
+    \ the smallest power of 2 that is at least twice the buffers
+    1 BEGIN  dup buffers 2* u<  WHILE  2*  REPEAT ;
+
 : block-cold ( -- )
-    block-fid off  last-block off
+    block-fid off  last-block off  block-hand off  last-miss on
     buffer-struct buffers * %alloc dup block-buffers ! ( addr )
     dup buffer-struct %size buffers * erase
-    buffers 0 ?DO dup buffer-block on next-buffer LOOP drop ;
+    buffers 0 ?DO dup buffer-block on next-buffer LOOP drop
+    block-hash-size dup 1- block-hash-mask !
+    cell% rot * %alloc dup block-hash !
+    block-hash-mask @ 1+ cells erase ;
 
 :noname ( -- )
     defers 'cold
     block-cold
 ; is 'cold
 
-:noname ( -- ) defers 'image  block-buffers off ; is 'image
+:noname ( -- ) defers 'image  block-buffers off  block-hash off ; is 'image
 
 block-cold
 
@@ -112,10 +132,13 @@ Defer flush-blocks ( -- ) \ gforth-internal
     dup block-limit u>= -35 and throw
     offset @ - chars/block chars um* get-block-fid reposition-file throw ;
 
-: update ( -- ) \ block
-    \G Mark the state of the current block buffer as assigned-dirty.
+: (update) ( -- ) \ gforth-internal
     last-block @ ?dup-IF  buffer-dirty on  THEN ;
 
+Defer update ( -- ) \ block
+\G Mark the state of the current block buffer as assigned-dirty.
+' (update) is update
+
 : save-buffer ( buffer -- ) \ gforth
     dup
     >r buffer-dirty @
@@ -128,21 +151,53 @@ Defer flush-blocks ( -- ) \ gforth-internal
     endif
     rdrop ;
 
+: block-bucket ( u wfileid -- a-addr ) \ gforth-internal
+    \ the hash table entry for block @i{u} of @i{wfileid}
+    4 rshift xor block-hash-mask @ and cells block-hash @ + ;
+
+: hash-buffer ( buffer -- ) \ gforth-internal
+    dup buffer-block @ over buffer-fid @ block-bucket
+    2dup @ swap buffer-chain !  ! ;
+
+: unhash-buffer ( buffer -- ) \ gforth-internal
+    dup buffer-block @ -1 = IF  drop  EXIT  THEN
+    dup buffer-block @ over buffer-fid @ block-bucket
+    BEGIN  dup @ 2 pick <>  WHILE  @ buffer-chain  REPEAT
+    swap buffer-chain @ swap ! ;
+
+: find-buffer ( u -- buffer|0 ) \ gforth-internal
+    \ the buffer assigned to block @i{u} of the current blocks file
+    get-block-fid 2dup block-bucket @ >r
+    BEGIN  r@  WHILE
+	over r@ buffer-block @ =  over r@ buffer-fid @ = and
+	IF  2drop r>  EXIT  THEN
+	r> buffer-chain @ >r
+    REPEAT
+    2drop r> ;
+
 : empty-buffer ( buffer -- ) \ gforth
-    dup buffer-block on buffer-dirty off ;
+    dup unhash-buffer
+    dup buffer-block on  dup buffer-ref off  buffer-dirty off ;
 
-: save-buffers  ( -- ) \ block
-    \G Transfer the contents of each @code{update}d block buffer to
-    \G mass storage, then mark all block buffers as assigned-clean.
+: (save-buffers) ( -- ) \ gforth-internal
     block-buffers @
     buffers 0 ?DO dup save-buffer next-buffer LOOP drop ;
 
-: empty-buffers ( -- ) \ block-ext
-    \G Mark all block buffers as unassigned; if any had been marked as
-    \G assigned-dirty (by @code{update}), the changes to those blocks
-    \G will be lost.
+Defer save-buffers  ( -- ) \ block
+\G Transfer the contents of each @code{update}d block buffer to
+\G mass storage, then mark all block buffers as assigned-clean.
+' (save-buffers) is save-buffers
+
+: (empty-buffers) ( -- ) \ gforth-internal
     block-buffers @
-    buffers 0 ?DO dup empty-buffer next-buffer LOOP drop ;
+    buffers 0 ?DO dup empty-buffer next-buffer LOOP drop
+    last-block off  last-miss on ;
+
+Defer empty-buffers ( -- ) \ block-ext
+\G Mark all block buffers as unassigned; if any had been marked as
+\G assigned-dirty (by @code{update}), the changes to those blocks
+\G will be lost.
+' (empty-buffers) is empty-buffers
 
 : flush ( -- ) \ block
     \G Perform the functions of @code{save-buffers} then
@@ -152,32 +207,69 @@ Defer flush-blocks ( -- ) \ gforth-internal
 
 ' flush IS flush-blocks
 
-: get-buffer ( u -- a-addr ) \ gforth-internal
-    0 buffers um/mod drop buffer-struct %size * block-buffers @ + ;
-
-: block ( u -- a-addr ) \ block
-    \G If a block buffer is assigned for block @i{u}, return its
-    \G start address, @i{a-addr}. Otherwise, assign a block buffer
-    \G for block @i{u} (if the assigned block buffer has been
-    \G @code{update}d, transfer the contents to mass storage), read
-    \G the block into the block buffer and return its start address,
-    \G @i{a-addr}.
+: set-buffers ( u -- ) \ gforth
+    \G @code{flush} the block buffers and replace them with @i{u}
+    \G new ones.
+    flush  block-buffers @ free throw  block-hash @ free throw
+    1 max to buffers  block-fid @ >r block-cold r> block-fid ! ;
+
+: nth-buffer ( u -- buffer ) \ gforth-internal
+    buffer-struct %size * block-buffers @ + ;
+
+: next-victim ( -- buffer ) \ gforth-internal
+    \ CLOCK replacement: skip (and clear) referenced buffers; never
+    \ replace the current block buffer if there is another one
+    BEGIN
+	block-hand @ dup 1+ dup buffers = IF  drop 0  THEN  block-hand !
+	nth-buffer dup buffer-ref @
+	over last-block @ = buffers 1 > and  or
+    WHILE
+	buffer-ref off
+    REPEAT ;
+
+: assign-buffer ( u -- buffer ) \ gforth-internal
+    next-victim dup save-buffer dup unhash-buffer
+    tuck buffer-block !  get-block-fid over buffer-fid !
+    dup hash-buffer ;
+
+: read-buffer ( buffer -- f ) \ gforth-internal
+    \ read the block assigned to @i{buffer}; @i{f} is true if the
+    \ whole block was in the file
+    >r r@ buffer-block @ block-position
+    r@ block-buffer chars/block r@ buffer-fid @ read-file throw
+    \ clear the rest of the buffer if the file is too short
+    r> block-buffer over chars + chars/block 2 pick chars - blank
+    chars/block = ;
+
+: read-blocks ( u n -- buffer ) \ gforth-internal
+    \ read block @i{u} and up to @i{n}-1 following blocks that are
+    \ not buffered yet; @i{buffer} is the buffer of block @i{u}
+    over assign-buffer dup >r  dup last-block !  dup buffer-ref on
+    read-buffer 0= IF  drop 1  THEN
+    1 ?DO
+	1+ dup block-limit u>= ?LEAVE  dup find-buffer ?LEAVE
+	dup assign-buffer read-buffer 0= ?LEAVE
+    LOOP
+    last-miss !  r> ;
+
+: (block) ( u -- a-addr ) \ gforth-internal
     dup offset @ u< -35 and throw
-    dup get-buffer >r
-    dup r@ buffer-block @ <>
-    r@ buffer-fid @ block-fid @ <> or
-    if
-	r@ save-buffer
-	dup block-position
-	r@ block-buffer chars/block get-block-fid read-file throw
-	\ clear the rest of the buffer if the file is too short
-	r@ block-buffer over chars + chars/block rot chars - blank
-	r@ buffer-block !
-	get-block-fid r@ buffer-fid !
-    else
-	drop
-    then
-    r> dup last-block ! block-buffer ;
+    dup find-buffer ?dup-IF
+	nip dup buffer-ref on
+    ELSE
+	dup last-miss @ 1+ = IF  read-ahead 1 max  ELSE  1  THEN
+	read-blocks
+    THEN
+    dup last-block ! block-buffer ;
+
+Defer block ( u -- a-addr ) \ block
+\G If a block buffer is assigned for block @i{u}, return its
+\G start address, @i{a-addr}. Otherwise, assign a block buffer
+\G for block @i{u} (if the assigned block buffer has been
+\G @code{update}d, transfer the contents to mass storage), read
+\G the block into the block buffer and return its start address,
+\G @i{a-addr}.
+' (block) is block
 
 : buffer ( u -- a-addr ) \ block
     \G If a block buffer is assigned for block @i{u}, return its
@@ -199,11 +291,13 @@ User scr ( -- a-addr ) \ block-ext s-c-r
 0 scr !
 
 \ nac31Mar1999 moved "scr @" to list to make the stack comment correct
-: updated?  ( n -- f ) \ gforth
-    \G Return true if @code{updated} has been used to mark block @i{n}
-    \G as assigned-dirty.
-    buffer
-    [ 0 buffer-dirty 0 block-buffer - ] Literal + @ ;
+: (updated?) ( n -- f ) \ gforth-internal
+    find-buffer dup IF  buffer-dirty @  THEN ;
+
+Defer updated?  ( n -- f ) \ gforth
+\G Return true if @code{updated} has been used to mark block @i{n}
+\G as assigned-dirty.
+' (updated?) is updated?
 
 : list ( u -- ) \ block-ext
     \G Display block @i{u}. In Gforth, the block is displayed as 16
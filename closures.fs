@@ -36,13 +36,72 @@ false Value 1t-closure?
     \G convert the xt of a closure on the heap to the @var{addr} with can be
     \G passed to @code{free} to get rid of the closure
 drop
+Variable closures-allocated \ heap closures, shown by metrics.fs
+Variable closures-freed
+User closure-up     \ the task that owns closure-region
+User closure-region 2 cells uallot drop \ chunk, next free address, end
+:noname defers 'image  closures-allocated off  closures-freed off
+    closure-up off ; is 'image
+
 : alloch ( size -- addr )
     \ addr is the end of the allocated region
-    dup allocate throw + ;
+    1 closures-allocated +!  dup allocate throw + ;
 : allocd ( size -- addr )
     \ addr is the end of the allocated region
     dp +! dp @ ;
 
+\ One-shot closures (:}h1) are allocated from a per-task region: each
+\ chunk counts the closures in it that have not been executed yet,
+\ plus one while it is the current chunk of its task.  A closure frees
+\ itself when it is executed (possibly in another task, so the count
+\ is changed atomically), and the last one frees the chunk.  When no
+\ closure in the current chunk is left, the task starts over at the
+\ beginning of the chunk.  The cell before a closure points to its
+\ chunk.  Chunks outlive arenas and are freed in other tasks, so they
+\ are managed with heap-allocate and heap-free.
+
+$1000 Value closure-chunk ( -- u ) \ gforth-experimental
+\G The number of aus of the chunks from which one-shot closures
+\G (@code{:@}h1}) are allocated.
+
+1 cells maxaligned Constant closure-chunk-head \ the count
+
+: closure-release ( chunk -- )
+    \ drop one reference to chunk
+    -1 over +!@ 1 = IF  heap-free throw  ELSE  drop  THEN ;
+
+: closure-chunk-new ( u -- chunk )
+    \ a chunk with room for u aus and one reference
+    closure-chunk-head + heap-allocate throw  1 over ! ;
+
+: closure-region-new ( -- )
+    \ the user area of a new task is a copy, so it does not own the chunk
+    closure-up @ up@ = IF  closure-region @ closure-release  THEN
+    up@ closure-up !
+    closure-chunk closure-chunk-new dup closure-region !
+    closure-chunk-head + dup closure-region cell+ !
+    closure-chunk + closure-region 2 cells + ! ;
+
+: closure-region-free ( -- )
+    \ release the current chunk when the task ends
+    closure-up @ up@ <> ?EXIT
+    closure-region @ closure-release  closure-up off ;
+
+: allocr ( size -- addr )
+    \ addr is the end of the allocated region
+    1 closures-allocated +!  dup cell+ maxaligned {: size n :}
+    n closure-chunk u> IF \ too large, it gets a chunk of its own
+	n closure-chunk-new dup closure-chunk-head + n +
+	tuck size - cell- !  EXIT  THEN
+    closure-up @ up@ <> IF  closure-region-new  THEN
+    closure-region @ @ 1 = IF \ no live closure left in the chunk
+	closure-region @ closure-chunk-head + closure-region cell+ !  THEN
+    closure-region cell+ @ n + closure-region 2 cells + @ u> IF
+	closure-region-new  THEN
+    1 closure-region @ +!@ drop
+    closure-region @  closure-region cell+ @ n + dup closure-region cell+ !
+    tuck size - cell- ! ;
+
 : >lp ( addr -- r:oldlp ) r> lp@ >r >r lp! ;
 opt: drop ]] lp@ >r lp! [[ ;
 : lp> ( r:oldlp -- ) r> r> lp! >r ;
@@ -50,14 +109,28 @@ opt: drop ]] r> lp! [[ ;
 
 Variable extra-locals ( additional hidden locals size )
 
+\ Escape analysis: if a :}d or :}h1 closure is passed to a word that
+\ does not keep it (see NONESCAPING) right after it has been created,
+\ it is turned into a :}l closure: the allocation is jumped over, and
+\ its memory becomes a nameless local of the creating definition.
+
+false Value auto-closure? \ the closure being compiled can become :}l
+Variable closure-start     \ the allocation code: lit size xt-alloc >lp
+Variable closure-alloc-end
+Variable closure-lp>       \ lp> behind the closure creation
+Variable closure-end       \ HERE behind it; 0 if no candidate
+Variable closure-free      \ the xt that frees a :}h1 closure in its code
+$Variable closure-consumers \ stack of words that do not keep closures
+
 locals-types definitions
 
 : :}* ( hmaddr u latest latestnt wid 0 a-addr1 u1 ... xt -- ) \ gforth-internal colon-close-brace-star
-    0 lit, lits, here cell- >r
-    compile, ]] >lp [[
+    closure-end off
+    0 lit, lits, here cell- >r  r@ cell- closure-start !
+    compile, ]] >lp [[  here closure-alloc-end !
     :}
     locals-size @ extra-locals @ + r> !
-    ['] endref, end-d
+    ['] endref, end-d  false to auto-closure?
     ['] execute is end-d  ['] noop is endref,
     extra-locals off activate-locals ;
 
@@ -71,7 +144,7 @@ locals-types definitions
 : :}d ( hmaddr u latest latestnt wid 0 a-addr1 u1 ... -- ) \ gforth colon-close-brace-d
     \G end a closure's locals declaration.  The closure will be allocated in
     \G the dictionary.
-    ['] allocd :}* ;
+    true to auto-closure?  ['] allocd :}* ;
 
 : :}h ( hmaddr u latest latestnt wid 0 a-addr1 u1 ... -- ) \ gforth colon-close-brace-h
     \G end a closure's locals declaration.  The closure will be allocated on
@@ -79,9 +152,10 @@ locals-types definitions
     ['] alloch :}* ;
 
 : :}h1 ( hmaddr u latest latestnt wid 0 a-addr1 u1 ... -- ) \ gforth colon-close-brace-h
-    \G end a closure's locals declaration.  The closure will be allocated on
-    \G the heap.
-    true to 1t-closure? ['] alloch :}* ;
+    \G end a closure's locals declaration.  The closure can be executed
+    \G once, and frees itself then; it is allocated from a region of
+    \G the current task.
+    true to 1t-closure?  true to auto-closure?  ['] allocr :}* ;
 
 forth definitions
 
@@ -138,7 +212,10 @@ forth definitions
 
 : free-closure ( xt -- ) \ gforth-internal
     \G free a heap-allocated closure
-    >addr free throw ;
+    1 closures-freed +!  >addr free throw ;
+: free-closure1 ( xt -- )
+    \ free a one-shot closure
+    1 closures-freed +!  >addr cell- @ closure-release ;
 : closure> ( hmaddr -- addr ) \ gforth-internal closure-end
     \G create trampoline head
     [ 0 >body ] [IF] dodoes: >l >l lp@ cell+
@@ -146,7 +223,8 @@ forth definitions
 : end-dclosure ( unravel-xt -- closure-sys )
     >r
     postpone lit here 0 ,
-    ]] closure> [[ r> execute
+    ]] closure> [[  here closure-lp> !  r> execute
+    auto-closure? IF  here closure-end !  THEN
     wrap@ next-section
     action-of :-hook >r  ['] closure-:-hook is :-hook
     :noname
@@ -157,10 +235,51 @@ forth definitions
 	2 cells of ]] 2@ 2>l [[ endof
 	dup negate ]] literal lp+! lp@ [[ dup ]] literal move [[
     endcase
-    1t-closure? IF  ]] free-closure [[ THEN
+    closure-free off
+    1t-closure? IF
+	postpone lit here closure-free ! ['] free-closure1 , ]] execute [[
+    THEN
     false to 1t-closure?
     ['] (closure-;]) colon-sys-xt-offset stick ;
 
+: nonescaping ( xt -- ) \ gforth-experimental
+    \G Declare that @i{xt} does not keep the xt on the top of the stack
+    \G after it returns (e.g., it just executes it).  A closure
+    \G ending with @code{:@}d} or @code{:@}h1} that is passed to such
+    \G a word right after it is created is allocated on the locals
+    \G stack instead, like with @code{:@}l}.
+    closure-consumers >stack ;
+
+: closure-consumer? ( xt -- flag )
+    closure-consumers $@ bounds ?DO
+	dup I @ = IF  drop true  UNLOOP EXIT  THEN
+    cell +LOOP  drop false ;
+
+: branch! ( a-target addr -- )
+    \ replace the two cells at addr with a branch to a-target; this
+    \ works until the native code is generated (by FLUSH-CODE)
+    ['] branch over !  cell+
+    [IFDEF] primbits  dup codestart @ - cell/ primbits $-bit  [THEN]
+    over +target ! ;
+
+: closure>locals ( -- )
+    \ turn the closure created right before HERE into a :}l closure
+    closure-start @ cell+ @ \ its size
+    closure-alloc-end @ closure-start @ branch!
+    closure-end @ closure-lp> @ branch!
+    closure-free @ ?dup-IF  ['] drop swap !  THEN
+    dummy-local, ;
+
+:noname ( xt -- )
+    closure-end @ here = IF
+	lits# 0= IF  dup closure-consumer? IF  closure>locals  THEN  THEN
+	closure-end off  THEN
+    defers compile, ; is compile,
+
+' execute nonescaping
+' catch nonescaping
+' $tmp nonescaping
+
 : [{: ( -- hmaddr u latest latestnt wid 0 ) \ gforth-experimental start-closure
     \G starts a closure.  Closures first declare the locals frame they are
     \G going to use, and then the code that is executed with those locals.
@@ -31,10 +31,51 @@ cover-end Constant cover-start
 [THEN]
 0 value dead-cov?
 
+\ per-task counter shards: tasks with a shard count there without
+\ synchronization, other tasks and counters beyond the shard count
+\ atomically; merge-cov-shards adds the shards to the counters
+
+User cov-shard  cov-shard off \ the current task's shard, see shard-inc#
+Variable cov-shards \ list of all shards, linked through their 4th cell
+4 cells Constant /cov-shard
+
+: new-cov-shard ( -- ) \ gforth-experimental
+    \G Give the current task its own copy of the coverage counters
+    \G present now, so it counts without synchronizing with other
+    \G tasks.  Tasks created by @code{newtask} etc. get one
+    \G automatically if @file{unix/pthread.fs} is loaded before
+    \G @file{coverage.fs}.
+    cover-end cover-start - dup /cov-shard + allocate throw >r
+    r@ /cov-shard + over erase
+    up@ r@ !  cover-start r@ cell+ !  r@ 2 cells + !
+    BEGIN  cov-shards @ dup r@ 3 cells + !
+	dup r@ swap cov-shards ?!@ =  UNTIL
+    r> cov-shard ! ;
+
+: merge-cov-shard ( shard -- )
+    dup 2 cells + @ over cell+ @ { shard size base }
+    size 0 U+DO
+	0 shard /cov-shard + I + cell+ !@  base I + cell+ +!@ drop
+    2 cells +LOOP ;
+
+: merge-cov-shards ( -- ) \ gforth-experimental
+    \G Add the counts of all tasks' shards to the coverage counters
+    \G (and reset the shards).  The words that show or save coverage
+    \G do this themselves.  If other tasks are running, a few of their
+    \G counts may get lost.
+    cov-shards @ BEGIN  dup  WHILE
+	    dup merge-cov-shard  3 cells + @  REPEAT  drop ;
+
+[IFDEF] thread-init
+    :noname defers thread-init  new-cov-shard ; is thread-init
+[THEN]
+:noname defers 'image  cov-shards off  cov-shard off ; is 'image
+
 : cov+, ( -- )
     coverage?  dead-code @ 0= and  loadfilename# @ 0>= and  IF
 	current-sourceview input-lexeme @ + cover,
-	postpone inc# cover-end , 0 cover,
+	postpone shard-inc# cover-end , [ ' cov-shard >body @ ] Literal ,
+	0 cover,
     THEN
     false to dead-cov? ;
 
@@ -63,6 +104,7 @@ cover-end Constant cover-start
 : cov% ( -- ) \ gforth-experimental cov-percent
     \G Print the percentage of basic blocks loaded after
     \G @file{coverage.fs} that are executed at least once.
+    merge-cov-shards
     0 cover-end cover-start U+DO
 	I cell+ @ 0<> -
     2 cells +LOOP  #2000 cells cover-end cover-start - */
@@ -70,6 +112,7 @@ cover-end Constant cover-start
 
 : .cover-raw ( -- ) \ gforth-experimental
     \G Print raw execution counts.
+    merge-cov-shards
     cover-end cover-start U+DO
 	I @ .sourceview ." : " I cell+ ? cr
     2 cells +LOOP ;
@@ -123,6 +166,7 @@ color-cover
 
 : .coverage ( -- ) \ gforth-experimental
     \G Show code with execution frequencies.
+    merge-cov-shards
     cr included-files $[]# 0 ?DO
 	I covered? IF
 	    I [: included-files $[]@ type ':' emit cr ;]
@@ -136,6 +180,7 @@ color-cover
     \G file that has the execution frequencies inserted.  We recommend
     \G to use @code{bw-cover} first (with the default
     \G @code{color-cover} you get escape sequences in the files).
+    merge-cov-shards
     included-files $[]# 0 ?DO
 	I covered? IF
 	    I [: included-files $[]@ type ." .cov" ;] $tmp
@@ -168,6 +213,7 @@ $10 buffer: cover-hash
 
 : save-cov ( -- ) \ gforth-experimental
     \G Save coverage counters.
+    merge-cov-shards
     cover-filename r/w create-file throw >r
     cover-start cover-end over - r@ write-file throw
     r> close-file throw ;
@@ -181,6 +227,47 @@ $10 buffer: cover-hash
     cover-start + cover-end!
     r> close-file throw ;
 
+\ compact dumps for merging the counts of several processes: "gfcov1",
+\ hash-cover, the number of counters and the counts, all numbers as
+\ unsigned LEB128
+
+$Variable cov-dump$
+
+: uleb$+ ( u -- )
+    BEGIN  dup $7F u>  WHILE  dup $80 or cov-dump$ c$+!  7 rshift  REPEAT
+    cov-dump$ c$+! ;
+
+: uleb@ ( c-addr1 u1 -- c-addr2 u2 u )
+    0 0 BEGIN
+	third 0= abort" truncated coverage dump"
+	2over drop c@ dup >r $7F and over lshift rot or swap 7 +
+	2swap 1 /string 2swap  r> $80 and 0=  UNTIL  drop ;
+
+: #cover ( -- u )  cover-end cover-start - 2 cells / ;
+
+: dump-cov ( c-addr u -- ) \ gforth-experimental
+    \G Write the coverage counters to the file @i{c-addr u} in a
+    \G compact format, for adding them to the counters of another
+    \G process running the same code with @code{merge-cov}.
+    merge-cov-shards
+    s" gfcov1" cov-dump$ $!  hash-cover cov-dump$ $+!  #cover uleb$+
+    cover-end cover-start U+DO  I cell+ @ uleb$+  2 cells +LOOP
+    w/o create-file throw >r
+    cov-dump$ $@ r@ write-file throw  r> close-file throw
+    cov-dump$ $free ;
+
+: merge-cov ( c-addr u -- ) \ gforth-experimental
+    \G Add the counters in the file @i{c-addr u}, written by
+    \G @code{dump-cov} in a process running the same code, to the
+    \G coverage counters.
+    slurp-file over >r
+    2dup s" gfcov1" string-prefix? 0= abort" not a coverage dump"
+    6 /string  dup $10 u< abort" truncated coverage dump"
+    over $10 hash-cover str= 0= abort" coverage dump for different code"
+    $10 /string uleb@ #cover <> abort" coverage dump for different code"
+    cover-end cover-start U+DO  uleb@ I cell+ +!@ drop  2 cells +LOOP
+    2drop r> free throw ;
+
 true to coverage?
 
 \ coverage tests
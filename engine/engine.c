@@ -54,6 +54,9 @@
 #ifdef HAVE_WCHAR_H
 #include <wchar.h>
 #endif
+#ifdef HAVE_MALLOC_H
+#include <malloc.h>
+#endif
 #include <sys/resource.h>
 #ifdef HAVE_FNMATCH_H
 #include <fnmatch.h>
@@ -305,6 +308,9 @@ static inline Cell slashfstage2(Cell n1, stagediv_t *stage1)
 #ifndef FTOSREG
 #define FTOSREG
 #endif
+#ifndef RTOSREG
+#define RTOSREG
+#endif
 #ifndef OPREG
 #define OPREG
 #endif
@@ -380,8 +386,8 @@ void throw(int code)
 #endif
 
 #if defined(HAS_FFCALL) || defined(HAS_LIBFFI)
-#define SAVE_REGS IF_fpTOS(fp[0]=fpTOS); gforth_SP=sp; gforth_FP=fp; gforth_RP=rp; gforth_LP=lp;
-#define REST_REGS sp=gforth_SP; fp=gforth_FP; rp=gforth_RP; lp=gforth_LP; IF_fpTOS(fpTOS=fp[0]);
+#define SAVE_REGS IF_fpTOS(fp[0]=fpTOS); IF_rpTOS(rp[0]=rpTOS); gforth_SP=sp; gforth_FP=fp; gforth_RP=rp; gforth_LP=lp;
+#define REST_REGS sp=gforth_SP; fp=gforth_FP; rp=gforth_RP; lp=gforth_LP; IF_fpTOS(fpTOS=fp[0]); IF_rpTOS(rpTOS=rp[0]);
 #endif
 
 #if !defined(ENGINE)
@@ -552,6 +558,7 @@ Label *gforth_engine(Xt *ip0 sr_proto)
   register Cell MAYBE_UNUSED spg spgREG;
   register Cell MAYBE_UNUSED sph sphREG;
   IF_fpTOS(register Float fpTOS FTOSREG;)
+  IF_rpTOS(register Cell rpTOS RTOSREG;)
 #endif /* !defined(GFORTH_DEBUGGING) */
 #if defined(DOUBLY_INDIRECT)
   static Label *symbols;
@@ -649,6 +656,7 @@ Label *gforth_engine(Xt *ip0 sr_proto)
 #endif
 
   IF_fpTOS(fpTOS = fp[0]);
+  IF_rpTOS(rpTOS = rp[0]);
 /*  prep_terminal(); */
   SET_IP(ip);
   SUPER_END; /* count the first block, too */
@@ -64,6 +64,7 @@ extern void* (*realloc_l)(void* addr, size_t size);
 #  undef USE_FTOS
 #  undef USE_NO_TOS
 #  undef USE_NO_FTOS
+#  undef USE_RTOS
 #  define USE_NO_TOS
 #  define USE_NO_FTOS
 
@@ -388,8 +389,12 @@ typedef Label *Xt;
 #define fpTOS (fp[0])
 #endif
 
+#ifdef USE_RTOS
+#define IF_rpTOS(x) x
+#else
 #define IF_rpTOS(x)
 #define rpTOS (rp[0])
+#endif
 
 typedef struct {
   Cell next_task;
@@ -519,6 +524,7 @@ int gforth_args(int argc, char ** argv, char ** path, char ** imagename);
 ImageHeader* gforth_loader(char* imagename, char* path);
 user_area* gforth_stacks(Cell dsize, Cell rsize, Cell fsize, Cell lsize);
 void gforth_free_stacks(user_area* t);
+UCell gforth_stack_used(Address start, Address end);
 void gforth_free(void * ptr);
 Cell gforth_go(Xt* ip0);
 Cell gforth_boot(int argc, char** argv, char* path);
@@ -569,6 +575,10 @@ Cell rename_file(Char *c_addr1, UCell u1, Char *c_addr2, UCell u2);
 struct Cellquad read_line(Char *c_addr, UCell u1, FILE *wfileid);
 struct Cellpair file_status(Char *c_addr, UCell u);
 struct Cellpair represent(Float r, Address c_addr, UCell u, Cell *np);
+struct Cellpair represent_shortest(Float r, Address c_addr, UCell u, Cell *np, UCell *lenp);
+#define DTOA_SHORTEST_MAX 32
+int dtoa_shortest(double r, char *buf, int *decpt);
+int fast_to_float(Char *c_addr, UCell u, Float *rp, Char dot);
 Cell to_float(Char *c_addr, UCell u, Float *r_p, Char dot);
 Float v_star(Float *f_addr1, Cell nstride1, Float *f_addr2, Cell nstride2, UCell ucount);
 void faxpy(Float ra, Float *f_x, Cell nstridex, Float *f_y, Cell nstridey, UCell ucount);
@@ -619,6 +629,22 @@ UDCell dadd(UDCell x, UDCell y);
 Cell memcasecmp(const Char *s1, const Char *s2, Cell n);
 
 DCell utf8_fetch_plus(Char * c_addr, UCell len);
+Char *ucell_digits(UCell u, Char *end, UCell base);
+
+/* sampling profiler */
+#define SAMPLE_CELLS 32 /* cells per sample */
+extern int vm_debugging;
+Cell sampler_start(UCell hz, UCell slots);
+void sampler_stop(void);
+Cell *sampler_next(void);
+void sampler_release(void);
+UCell sampler_dropped(void);
+#define PERF_MAP 1
+#define PERF_JITDUMP 2
+extern int perf_map_mode;
+Cell perf_map_region(Address code, UCell len, Char *name, UCell namelen);
+extern UCell heap_allocs, heap_frees, heap_resizes;
+char *engine_metric(UCell u, Cell *value);
 
 void vm_print_profile(FILE *file);
 void vm_count_block(Xt *ip);
@@ -633,6 +659,8 @@ int forget_dyncode3(Label *tc);
 Label decompile_code(Label prim);
 extern const char * const prim_names[];
 extern DynamicInfo *decompile_prim3(Label *tcp);
+Label *next_dyncode(void);
+Label *dyncode_tc(Address pc);
 extern Cell fetch_decompile_prim(Cell *a_addr);
 int state_map(int);
 
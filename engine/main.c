@@ -71,6 +71,12 @@ PER_THREAD stackpointers gforth_SPs;
 
 user_area* gforth_main_UP=NULL;
 
+#ifdef GFORTH_DEBUGGING
+int vm_debugging=1; /* ip and rp are kept in gforth_SPs (for sampler.c) */
+#else
+int vm_debugging=0;
+#endif
+
 #ifdef HAS_FFCALL
 
 #include <callback.h>
@@ -792,7 +798,11 @@ Cell gforth_go(Xt* ip0)
   jmp_buf* old_handler;
 #endif
   Cell signal_data_stack[24];
+#ifdef USE_RTOS
+  Cell signal_return_stack[16+1]; /* rp[0] is cached even when empty */
+#else
   Cell signal_return_stack[16];
+#endif
   Float signal_fp_stack[1];
   Cell result;
 
@@ -1255,6 +1265,7 @@ static void check_prims(Label symbols1[])
 /* Dynamic info for decompilation */
 DynamicInfo *dynamicinfos = NULL; /* 2^n-sized growable array */
 long ndynamicinfos=0; /* index of next dynamicinfos entry */
+static long ndyncode_reported=0; /* entries returned by next_dyncode() */
 
 DynamicInfo *dynamic_info3(Label *tcp)
 {
@@ -1267,6 +1278,28 @@ DynamicInfo *dynamic_info3(Label *tcp)
   return NULL;
 }
 
+Label *next_dyncode(void)
+/* the tcp of the oldest dynamicinfos entry not yet returned, or NULL */
+{
+  if (ndyncode_reported < ndynamicinfos)
+    return dynamicinfos[ndyncode_reported++].tcp;
+  return NULL;
+}
+
+Label *dyncode_tc(Address pc)
+/* the tcp of the piece of dynamically generated native code that
+   contains pc, or NULL */
+{
+  DynamicInfo *di;
+  if (dynamicinfos != NULL) {
+    for (di=&dynamicinfos[ndynamicinfos]; di-- > dynamicinfos; )
+      if (di->length > 0 &&
+          pc >= (Address)*di->tcp && pc < (Address)*di->tcp + di->length)
+        return di->tcp;
+  }
+  return NULL;
+}
+
 #if !(defined(DOUBLY_INDIRECT) || defined(INDIRECT_THREADED))
 static DynamicInfo *add_dynamic_info()
 /* reserves space for a new Dynamicinfo, returning a pointer to it (for
@@ -1545,8 +1578,11 @@ int forget_dyncode3(Label *tc)
   Address code = *tc;
 
   DynamicInfo *di = dynamic_info3(tc);
-  if (di != NULL)
+  if (di != NULL) {
     ndynamicinfos = di-dynamicinfos;
+    if (ndyncode_reported > ndynamicinfos)
+      ndyncode_reported = ndynamicinfos;
+  }
   for (pp=&code_block_list, p=*pp; p!=NULL; pp=&(p->next), p=*pp) {
     if (code >= p->block && code < p->block+p->size) {
       next_code_blockp = &(p->next);
@@ -1760,6 +1796,9 @@ long lb_newstate_equiv = 0;
 long lb_newstate_new = 0;
 long lb_applicable_base_rules = 0;
 long lb_applicable_chain_rules = 0;
+long lb_prims = 0;       /* primitives in the basic blocks */
+long lb_super_insts = 0; /* superinstructions selected for them */
+long lb_super_prims = 0; /* primitives covered by these superinstructions */
 
 #if !(defined(DOUBLY_INDIRECT) || defined(INDIRECT_THREADED))
 static void init_waypoints(struct waypoint ws[])
@@ -1944,6 +1983,7 @@ static void optimize_rewrite(Cell *instps[], PrimNum origs[], int ninsts)
   instps[ninsts] = instps[ninsts-1]+cl->imm_ops+1;
   /* !! better provide this info through the interface */
   lb_basic_blocks++;
+  lb_prims += ninsts;
   ts[ninsts] = termstate;
 #ifndef NO_DYNAMIC
   if (print_sequences) {
@@ -2038,6 +2078,10 @@ static void optimize_rewrite(Cell *instps[], PrimNum origs[], int ninsts)
 	assert(p == origs[i]);
 #endif
 	tc2 = compile_prim_dyn(p);
+	if (c->length > 1) {
+	  lb_super_insts++;
+	  lb_super_prims += c->length;
+	}
 	no_relocatable = !is_relocatable(p);
 	if (no_transition || no_relocatable) {
 	  /* !! actually what we care about is if and where
@@ -2343,6 +2387,8 @@ ImageHeader* gforth_loader(char* imagename, char* path)
   return gforth_engine(0 sr_call);
 }
 #else
+static void image_options(Char *preamble, Cell size);
+
 ImageHeader* gforth_loader(char* imagename, char* path)
 /* returns the address of the image proper (after the preamble) */
 {
@@ -2385,6 +2431,7 @@ ImageHeader* gforth_loader(char* imagename, char* path)
   image = dict_alloc_read(imagefile, preamblesize+sizes[0],
 			  dictsize, data_offset);
   if(image==NULL) return NULL;
+  image_options(image, preamblesize);
 
   vm_prims = gforth_engine(0 sr_call);
   check_prims(vm_prims);
@@ -2537,8 +2584,86 @@ enum {
   ss_min_nexts,
   opt_code_block_size,
   opt_opt_ip_updates,
+  opt_perf_map,
+  opt_jitdump,
 };
 
+static UCell cmdline_options = 0; /* bit c-ss_number: option c was given */
+#define CMDLINE(c) (cmdline_options & (1<<((c)-ss_number)))
+
+#ifndef STANDALONE
+static void image_options(Char *preamble, Cell size)
+/* An image can contain a preamble line "#tune <options>" (written by
+   savesystem, see tune.fs).  Apply the code generation options there
+   that were not given on the command line. */
+{
+  char line[256];
+  char *opt, *p;
+  Cell i, n;
+  int ss_cost_given = CMDLINE(ss_min_codesize) || CMDLINE(ss_min_ls) ||
+    CMDLINE(ss_min_lsu) || CMDLINE(ss_min_nexts);
+
+  for (i=0; i+7<=size; i++)
+    if (memcmp(preamble+i, "\n#tune ", 7) == 0)
+      break;
+  if (i+7 > size)
+    return;
+  for (i+=7, n=0; i<size && preamble[i]!='\n' && n<sizeof(line)-1; i++, n++)
+    line[n] = preamble[i];
+  line[n] = '\0';
+  debugp(stderr, "image options: %s\n", line);
+  for (opt=strtok(line, " "); opt!=NULL; opt=strtok(NULL, " ")) {
+    char *arg = strchr(opt, '=');
+    if (arg != NULL)
+      *arg++ = '\0';
+    if (strncmp(opt, "--", 2) != 0)
+      continue;
+    p = opt+2;
+    if (!strcmp(p, "ss-number") && arg) {
+      if (!CMDLINE(ss_number))
+	static_super_number = atoi(arg);
+    } else if (!strcmp(p, "ss-states") && arg) {
+      if (!CMDLINE(ss_states))
+	maxstates = max(min(atoi(arg),MAX_STATE),1);
+    } else if (!strcmp(p, "opt-ip-updates") && arg) {
+      if (!CMDLINE(opt_opt_ip_updates)) {
+	opt_ip_updates = atoi(arg);
+	opt_ip_updates_branch = opt_ip_updates>>3;
+	opt_ip_updates &= 7;
+      }
+    } else if (!strcmp(p, "code-block-size") && arg) {
+      if (!CMDLINE(opt_code_block_size)) {
+	Cell s = convsize(arg,sizeof(Char));
+	if (s != -1L)
+	  code_area_size = s;
+      }
+    } else if (!strcmp(p, "ss-greedy"))
+      ss_greedy = 1;
+    else if (!strcmp(p, "tpa-noequiv"))
+      tpa_noequiv = 1;
+    else if (!strcmp(p, "tpa-noautomaton"))
+      tpa_noautomaton = 1;
+#ifndef NO_DYNAMIC
+    else if (!strcmp(p, "ss-min-codesize")) {
+      if (!ss_cost_given)
+	ss_cost = cost_codesize;
+    }
+#endif
+    else if (!strcmp(p, "ss-min-ls")) {
+      if (!ss_cost_given)
+	ss_cost = cost_ls;
+    } else if (!strcmp(p, "ss-min-lsu")) {
+      if (!ss_cost_given)
+	ss_cost = cost_lsu;
+    } else if (!strcmp(p, "ss-min-nexts")) {
+      if (!ss_cost_given)
+	ss_cost = cost_nexts;
+    } else
+      fprintf(stderr, "%s: unknown image option %s\n", progname, opt);
+  }
+}
+#endif
+
 static void print_diag()
 {
 
@@ -2661,6 +2786,8 @@ int gforth_args(int argc, char ** argv, char ** path, char ** imagename)
       {"print-nonreloc", no_argument, &print_nonreloc, 1},
       {"print-prims", no_argument, &print_prims, 1},
       {"print-sequences", no_argument, &print_sequences, 1},
+      {"perf-map", no_argument, NULL, opt_perf_map},
+      {"jitdump", no_argument, NULL, opt_jitdump},
       {"ss-number", required_argument, NULL, ss_number},
       {"ss-states", required_argument, NULL, ss_states},
 #ifndef NO_DYNAMIC
@@ -2679,6 +2806,8 @@ int gforth_args(int argc, char ** argv, char ** path, char ** imagename)
     
     c = getopt_long(argc, argv, "+i:m:d:r:f:l:p:vhoncsxD", opts, &option_index);
     
+    if (c >= ss_number)
+      cmdline_options |= 1<<(c-ss_number);
     switch (c) {
     case EOF: return 0;
     case '?': optind=oldoptind; return 0;
@@ -2703,6 +2832,8 @@ int gforth_args(int argc, char ** argv, char ** path, char ** imagename)
       opt_ip_updates_branch = opt_ip_updates>>3;
       opt_ip_updates &= 7;
       break;
+    case opt_perf_map: perf_map_mode |= PERF_MAP; break;
+    case opt_jitdump: perf_map_mode |= PERF_JITDUMP; break;
     case ss_number: static_super_number = atoi(optarg); break;
     case ss_states: maxstates = max(min(atoi(optarg),MAX_STATE),1); break;
 #ifndef NO_DYNAMIC
@@ -2728,6 +2859,7 @@ Engine Options:\n\
   -f SIZE, --fp-stack-size=SIZE	    Specify floating point stack size\n\
   -h, --help			    Print this message and exit\n\
   --ignore-async-signals	    Ignore instead of THROWing async. signals\n\
+  --jitdump			    Write generated code to jit-<pid>.dump\n\
   -i FILE, --image-file=FILE	    Use image FILE instead of `gforth.fi'\n\
   -l SIZE, --locals-stack-size=SIZE Specify locals stack size\n\
   -m SIZE, --dictionary-size=SIZE   Specify Forth dictionary size\n\
@@ -2741,6 +2873,7 @@ Engine Options:\n\
   --opt-ip-updates=n                ip-update optimization (0=disabled)\n\
   --opt-ip-updates-branch=n         ip-update branch optimization (0=disabled)\n\
   -p PATH, --path=PATH		    Search path for finding image and sources\n\
+  --perf-map			    Name generated code in /tmp/perf-<pid>.map\n\
   --print-metrics		    Print some code generation metrics on exit\n\
   --print-nonreloc		    Print non-relocatable primitives at start\n\
   --print-prims			    Print primitives with usage counts on exit\n\
@@ -2810,6 +2943,9 @@ void gforth_printmetrics()
 	      cost_sums[i].metricname, cost_sums[i].sum);
 #endif
     fprintf(stderr,"lb_basic_blocks = %ld\n", lb_basic_blocks);
+    fprintf(stderr,"lb_prims = %ld\n", lb_prims);
+    fprintf(stderr,"lb_super_insts = %ld\n", lb_super_insts);
+    fprintf(stderr,"lb_super_prims = %ld\n", lb_super_prims);
     fprintf(stderr,"lb_labeler_steps = %ld\n", lb_labeler_steps);
     fprintf(stderr,"lb_labeler_automaton = %ld\n", lb_labeler_automaton);
     fprintf(stderr,"lb_labeler_dynprog = %ld\n", lb_labeler_dynprog);
@@ -2831,6 +2967,38 @@ void gforth_printmetrics()
   }
 }
 
+UCell heap_allocs = 0, heap_frees = 0, heap_resizes = 0;
+
+static long code_blocks_size(void)
+{
+  long size=0;
+#ifndef NO_DYNAMIC
+  struct code_block_list *p;
+  for (p=code_block_list; p!=NULL; p=p->next)
+    size += p->size;
+#endif /* !defined(NO_DYNAMIC) */
+  return size;
+}
+
+char *engine_metric(UCell u, Cell *value)
+/* name and current value of engine metric u, or NULL if u is beyond
+   the last metric; the names are used by metrics.fs */
+{
+  switch (u) {
+  case 0: *value = dyncodesize(); return "dyncode_bytes";
+  case 1: *value = code_blocks_size(); return "code_block_bytes";
+  case 2: *value = ndynamicinfos; return "dyncode_pieces";
+  case 3: *value = lb_basic_blocks; return "basic_blocks";
+  case 4: *value = lb_prims; return "prims_compiled";
+  case 5: *value = lb_super_insts; return "supers_compiled";
+  case 6: *value = lb_super_prims; return "prims_in_supers";
+  case 7: *value = heap_allocs; return "heap_allocates";
+  case 8: *value = heap_frees; return "heap_frees";
+  case 9: *value = heap_resizes; return "heap_resizes";
+  default: return NULL;
+  }
+}
+
 void gforth_cleanup()
 {
 #if defined(SIGPIPE) && !defined(STANDALONE)
@@ -2882,6 +3050,9 @@ user_area* gforth_stacks(Cell dsize, Cell fsize, Cell rsize, Cell lsize)
 #if !(defined(GFORTH_DEBUGGING) || defined(INDIRECT_THREADED) || defined(DOUBLY_INDIRECT) || defined(VM_PROFILING))
     up0->sp0 -= 8; /* make stuff below bottom accessible for stack caching */
     up0->fp0--;
+# ifdef USE_RTOS
+    up0->rp0--; /* rpTOS is loaded from and saved to rp[0] even when empty */
+# endif
 #else
 # ifdef DEBUG
     up0->sp0--; // debug will print TOS even if the stack is empty
@@ -2944,6 +3115,41 @@ void gforth_free_stacks(user_area * t)
     debugp(stderr,"sucess\n");
 }
 
+UCell gforth_stack_used(Address start, Address end)
+/* How much of the stack region start..end (start page-aligned, the
+   stack grows down from end) has been used so far.  The pages of the
+   mmapped stacks are all-zero until touched, so we look for the
+   lowest resident page with mincore(), and then for the lowest
+   non-zero cell from there. */
+{
+  Address p = start;
+#if defined(HAVE_MMAP) && defined(HAVE_MINCORE)
+  char vec[64];
+  Address q;
+
+  for (q = start; q < end; q = p) {
+    size_t len = end - q;
+    size_t i, n;
+    if (len > sizeof(vec)*pagesize)
+      len = sizeof(vec)*pagesize;
+    if (mincore(q, len, (void *)vec) != 0)
+      break; /* not mmapped; just scan */
+    n = (len+pagesize-1)/pagesize;
+    for (i = 0; i < n && !(vec[i]&1); i++)
+      ;
+    p = q + i*pagesize;
+    if (i < n)
+      break;
+  }
+  if (p > end)
+    p = end;
+#endif
+  for (; p < end; p += sizeof(Cell))
+    if (*(Cell *)p != 0)
+      break;
+  return end - p;
+}
+
 void gforth_setstacks(user_area * t)
 {
   gforth_magic = GFORTH_MAGIC; /* mark task as maintained */
@@ -0,0 +1,202 @@
+/* Tell native profilers about dynamically generated code
+
+  Authors: Anton Ertl, Bernd Paysan
+  Copyright (C) 2026 Free Software Foundation, Inc.
+
+  This file is part of Gforth.
+
+  Gforth is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation, either version 3
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see http://www.gnu.org/licenses/.
+*/
+
+/* With --perf-map, every region of dynamically generated native code
+   is written to /tmp/perf-<pid>.map, which perf and other Linux
+   profilers use for symbolizing anonymous executable memory.  With
+   --jitdump, the regions (including their code) are written to
+   jit-<pid>.dump in $JITDUMPDIR (default: the current directory); run
+   "perf record -k mono", then "perf inject --jit" to use it.
+
+   The names of the regions (primitive sequence and owning word) are
+   computed in Forth (perfmap.fs), which calls perf_map_region() after
+   each batch of code generation. */
+
+#include "config.h"
+#include "forth.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <elf.h>
+#include <sys/syscall.h>
+#endif
+
+int perf_map_mode = 0; /* PERF_MAP|PERF_JITDUMP, set by engine options */
+
+static FILE *perf_map_file = NULL;
+static FILE *jitdump_file = NULL;
+static UCell jitdump_index = 0;
+
+/* the jitdump format, as specified in the Linux sources
+   (tools/perf/Documentation/jitdump-specification.txt) */
+#define JITDUMP_MAGIC 0x4A695444
+#define JIT_CODE_LOAD 0
+
+struct jitdump_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t total_size;
+  uint32_t elf_mach;
+  uint32_t pad1;
+  uint32_t pid;
+  uint64_t timestamp;
+  uint64_t flags;
+};
+
+struct jitdump_code_load {
+  uint32_t id;
+  uint32_t total_size;
+  uint64_t timestamp;
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t vma;
+  uint64_t code_addr;
+  uint64_t code_size;
+  uint64_t code_index;
+  /* followed by the 0-terminated name and the code */
+};
+
+static uint64_t jitdump_timestamp(void)
+/* must be the clock used by "perf record -k mono" */
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec)*1000000000+ts.tv_nsec;
+#else
+  return 0;
+#endif
+}
+
+static uint32_t jitdump_elf_mach(void)
+{
+#if defined(__x86_64__) && defined(EM_X86_64)
+  return EM_X86_64;
+#elif defined(__i386__) && defined(EM_386)
+  return EM_386;
+#elif defined(__aarch64__) && defined(EM_AARCH64)
+  return EM_AARCH64;
+#elif defined(__arm__) && defined(EM_ARM)
+  return EM_ARM;
+#elif defined(__riscv) && defined(EM_RISCV)
+  return EM_RISCV;
+#elif (defined(__powerpc64__) || defined(__ppc64__)) && defined(EM_PPC64)
+  return EM_PPC64;
+#else
+  return 0; /* EM_NONE */
+#endif
+}
+
+static void perf_map_close(void)
+{
+  if (perf_map_file != NULL)
+    fclose(perf_map_file);
+  if (jitdump_file != NULL)
+    fclose(jitdump_file);
+  perf_map_file = jitdump_file = NULL;
+}
+
+static int jitdump_open(void)
+{
+  char *dir = getenv("JITDUMPDIR");
+  char name[strlen(dir ? dir : ".")+40];
+  struct jitdump_header h;
+
+  sprintf(name, "%s/jit-%ld.dump", dir ? dir : ".", (long)getpid());
+  if ((jitdump_file = fopen(name, "w+")) == NULL)
+    return 1;
+#if defined(HAVE_MMAP) && defined(PROT_EXEC)
+  /* perf finds the dump through this mapping in the recorded events */
+  if (mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ|PROT_EXEC, MAP_PRIVATE,
+	   fileno(jitdump_file), 0) == MAP_FAILED) {
+    fclose(jitdump_file);
+    jitdump_file = NULL;
+    return 1;
+  }
+#endif
+  memset(&h, 0, sizeof(h));
+  h.magic = JITDUMP_MAGIC;
+  h.version = 1;
+  h.total_size = sizeof(h);
+  h.elf_mach = jitdump_elf_mach();
+  h.pid = getpid();
+  h.timestamp = jitdump_timestamp();
+  fwrite(&h, sizeof(h), 1, jitdump_file);
+  return 0;
+}
+
+static int perf_map_open(void)
+/* open the files on first use; returns true on failure */
+{
+  static int opened = 0;
+
+  if (opened)
+    return perf_map_file == NULL && jitdump_file == NULL;
+  opened = 1;
+  if (perf_map_mode & PERF_MAP) {
+    char name[40];
+    sprintf(name, "/tmp/perf-%ld.map", (long)getpid());
+    perf_map_file = fopen(name, "w");
+  }
+  if (perf_map_mode & PERF_JITDUMP)
+    jitdump_open();
+  atexit(perf_map_close);
+  return perf_map_file == NULL && jitdump_file == NULL;
+}
+
+Cell perf_map_region(Address code, UCell len, Char *name, UCell namelen)
+/* report native code code len as name namelen; returns an ior */
+{
+  if (perf_map_mode == 0)
+    return 0;
+  if (perf_map_open())
+    return IOR(1);
+  if (perf_map_file != NULL)
+    fprintf(perf_map_file, "%lx %lx %.*s\n",
+	    (unsigned long)code, (unsigned long)len, (int)namelen, name);
+  if (jitdump_file != NULL) {
+    struct jitdump_code_load r;
+    r.id = JIT_CODE_LOAD;
+    r.total_size = sizeof(r)+namelen+1+len;
+    r.timestamp = jitdump_timestamp();
+    r.pid = getpid();
+#if defined(__linux__) && defined(SYS_gettid)
+    r.tid = syscall(SYS_gettid);
+#else
+    r.tid = r.pid;
+#endif
+    r.vma = r.code_addr = (uint64_t)(UCell)code;
+    r.code_size = len;
+    r.code_index = jitdump_index++;
+    fwrite(&r, sizeof(r), 1, jitdump_file);
+    fwrite(name, 1, namelen, jitdump_file);
+    fputc(0, jitdump_file);
+    fwrite(code, 1, len, jitdump_file);
+  }
+  return 0;
+}
@@ -0,0 +1,242 @@
+/* Sampling profiler: record the VM state on SIGPROF
+
+  Authors: Anton Ertl, Bernd Paysan
+  Copyright (C) 2026 Free Software Foundation, Inc.
+
+  This file is part of Gforth.
+
+  Gforth is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation, either version 3
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, see http://www.gnu.org/licenses/.
+*/
+
+/* The SIGPROF handler only copies raw cells into a preallocated ring
+   of fixed-size sample slots; mapping them to words is done later in
+   Forth (profiler.fs), with the machinery used for backtraces.
+
+   A slot contains:
+     cell 0: 0 if the slot is free, otherwise 1 + the number of
+             return-stack items in the slot
+     cells 1, 2: candidates for the VM's ip (0 if none)
+     cell 3: the interrupted machine pc (0 if unknown)
+     cells 4...: the return stack items, starting with the top
+
+   In the debugging engines (gforth, gforth-itc, gforth-ditc) the ip
+   and rp are kept in gforth_SPs, so the sample is exact.  In
+   gforth-fast they live in machine registers; there we look for them
+   in the interrupted machine context: rp is the lowest register value
+   that points into the return stack of the current task, and the ip
+   candidates are register values pointing into the dictionary; the
+   profiler only accepts candidates that look like threaded code.
+
+   The machine pc is mapped to threaded code (and thus to a word) in
+   the profiler with dyncode>tc if it points into dynamically
+   generated native code; this works in all engines. */
+
+#include "config.h"
+#include "forth.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/time.h>
+#if defined(HAVE_UCONTEXT_H) || defined(__linux__)
+#include <ucontext.h>
+#endif
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#define UC_REGS(uc) ((Cell *)((uc)->uc_mcontext.gregs))
+#define UC_NREGS(uc) (sizeof((uc)->uc_mcontext.gregs)/sizeof(Cell))
+#ifdef __x86_64__
+#define UC_PC(uc) ((uc)->uc_mcontext.gregs[REG_RIP])
+#else
+#define UC_PC(uc) ((uc)->uc_mcontext.gregs[REG_EIP])
+#endif
+#elif defined(__linux__) && defined(__aarch64__)
+#define UC_REGS(uc) ((Cell *)((uc)->uc_mcontext.regs))
+#define UC_NREGS(uc) 31
+#define UC_PC(uc) ((uc)->uc_mcontext.pc)
+#endif
+
+#if defined(SIGPROF) && defined(SA_SIGINFO) && defined(ITIMER_PROF)
+static Cell *sample_buf = NULL;
+static UCell sample_slots = 0;
+static volatile UCell sample_write = 0; /* next slot to be filled */
+static volatile UCell sample_read = 0;  /* next slot to be consumed */
+static volatile UCell sample_dropped = 0;
+static struct sigaction sample_oldaction;
+static int sample_running = 0;
+
+static void sample_handler(int sig, siginfo_t *info, void *context)
+{
+  user_area *up = gforth_UP;
+  Cell *rp = NULL;
+  Xt *ip0 = NULL, *ip1 = NULL;
+  Cell pc = 0;
+  Cell *slot;
+  UCell w, n, i;
+
+  if (up == NULL || sample_buf == NULL)
+    return;
+#ifdef UC_PC
+  pc = (Cell)UC_PC((ucontext_t *)context);
+#endif
+  if (vm_debugging) {
+    rp = gforth_SPs.s_rp;
+    ip0 = saved_ip;
+  } else {
+#ifdef UC_REGS
+    ucontext_t *uc = (ucontext_t *)context;
+    Cell *regs = UC_REGS(uc);
+    Cell dict = (Cell)gforth_header;
+    Cell dictend = dict + gforth_header->dict_size;
+    for (i = 0; i < UC_NREGS(uc); i++) {
+      Cell r = regs[i];
+      if ((r & (sizeof(Cell)-1)) != 0)
+        continue;
+      if (r > (Cell)up->sp0 && r <= (Cell)up->rp0) {
+        if (rp == NULL || r < (Cell)rp)
+          rp = (Cell *)r;
+      } else if (r >= dict && r < dictend) {
+        if (ip0 == NULL)
+          ip0 = (Xt *)r;
+        else if (ip1 == NULL && (Xt *)r != ip0)
+          ip1 = (Xt *)r;
+      }
+    }
+#endif
+  }
+  if (rp == NULL || rp > up->rp0 || rp <= up->sp0)
+    n = 0;
+  else {
+    n = up->rp0 - rp;
+    if (n > SAMPLE_CELLS-4)
+      n = SAMPLE_CELLS-4;
+  }
+  do {
+    w = sample_write;
+    if (w - sample_read >= sample_slots) {
+      __sync_fetch_and_add(&sample_dropped, 1);
+      return;
+    }
+  } while (!__sync_bool_compare_and_swap(&sample_write, w, w+1));
+  slot = sample_buf + (w % sample_slots) * SAMPLE_CELLS;
+  slot[1] = (Cell)ip0;
+  slot[2] = (Cell)ip1;
+  slot[3] = pc;
+  for (i = 0; i < n; i++)
+    slot[4+i] = rp[i];
+  __sync_synchronize();
+  slot[0] = n+1;
+}
+
+Cell sampler_start(UCell hz, UCell slots)
+/* start taking hz samples per second of CPU time; keep up to slots
+   unconsumed samples; returns an ior */
+{
+  struct sigaction action;
+  struct itimerval timer;
+  Cell *buf;
+
+  if (sample_running || hz == 0 || hz > 1000000 || slots == 0)
+    return -24; /* invalid numeric argument */
+  buf = calloc(slots, SAMPLE_CELLS*sizeof(Cell));
+  if (buf == NULL)
+    return IOR(1);
+  free(sample_buf);
+  sample_buf = buf;
+  sample_slots = slots;
+  sample_write = sample_read = sample_dropped = 0;
+  action.sa_sigaction = sample_handler;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART|SA_SIGINFO;
+  if (sigaction(SIGPROF, &action, &sample_oldaction))
+    return IOR(1);
+  timer.it_interval.tv_sec = (1000000/hz) / 1000000;
+  timer.it_interval.tv_usec = (1000000/hz) % 1000000;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, NULL)) {
+    sigaction(SIGPROF, &sample_oldaction, NULL);
+    return IOR(1);
+  }
+  sample_running = 1;
+  return 0;
+}
+
+void sampler_stop(void)
+/* stop sampling; the samples taken can still be consumed */
+{
+  struct itimerval timer;
+
+  if (!sample_running)
+    return;
+  memset(&timer, 0, sizeof(timer));
+  setitimer(ITIMER_PROF, &timer, NULL);
+  sigaction(SIGPROF, &sample_oldaction, NULL);
+  sample_running = 0;
+}
+
+Cell *sampler_next(void)
+/* the next complete sample, or NULL */
+{
+  Cell *slot;
+
+  if (sample_buf == NULL || sample_read == sample_write)
+    return NULL;
+  slot = sample_buf + (sample_read % sample_slots) * SAMPLE_CELLS;
+  if (slot[0] == 0) /* still being written */
+    return NULL;
+  __sync_synchronize();
+  return slot;
+}
+
+void sampler_release(void)
+/* free the slot returned by sampler_next() */
+{
+  Cell *slot;
+
+  if (sampler_next() == NULL)
+    return;
+  slot = sample_buf + (sample_read % sample_slots) * SAMPLE_CELLS;
+  slot[0] = 0;
+  __sync_synchronize();
+  sample_read++;
+}
+
+UCell sampler_dropped(void)
+{
+  return sample_dropped;
+}
+#else /* no SIGPROF */
+Cell sampler_start(UCell hz, UCell slots)
+{
+  return -21; /* unsupported operation */
+}
+
+void sampler_stop(void)
+{
+}
+
+Cell *sampler_next(void)
+{
+  return NULL;
+}
+
+void sampler_release(void)
+{
+}
+
+UCell sampler_dropped(void)
+{
+  return 0;
+}
+#endif
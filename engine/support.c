@@ -32,6 +32,7 @@
 #ifndef STANDALONE
 #include <dirent.h>
 #include <math.h>
+#include <float.h>
 #include <ctype.h>
 #include <errno.h>
 #include <sys/types.h>
@@ -644,24 +645,37 @@ struct Cellpair represent(Float r, Address c_addr1, UCell u, Cell *np)
       }
       repstr("infinity",c_addr,u);
     } else {
+      char sbuf[DTOA_SHORTEST_MAX];
+      int slen, sdecpt;
       ok = -1;
       r = fabs(r);
-      if(snprintf(buf,u+8,"%.*e",(int)u-1,r)<0)
-	fprintf(stderr,"represent error: %s\n", strerror(errno));
-      for (s=buf, t=c_addr;; s++) {
-	char c = *s;
-	if ('0'<=c && c<='9')
-	  *t++ = c;
-	else if (c != '.')
-	  break;
-      }
-      /* fprintf(stderr,"r=%.*e, t=%p, c_addr=%p, u=%ld\n",(int)u-1,r,t,c_addr,u);*/
-      assert(t == c_addr+u);
-      assert(*s == 'e');
-      s++;
-      if (*s == '+')
+      /* For normal numbers, the shortest representation is closer to
+	 r than half a unit in the DBL_DIGth digit, so if it has at most
+	 u<=DBL_DIG digits, padding it with zeros gives the correctly
+	 rounded u-digit representation. */
+      if (u <= DBL_DIG && r >= DBL_MIN &&
+	  (slen = dtoa_shortest(r, sbuf, &sdecpt)) <= u) {
+	memcpy(c_addr, sbuf, slen);
+	memset(c_addr+slen, '0', u-slen);
+	decpt = sdecpt;
+      } else {
+	if(snprintf(buf,u+8,"%.*e",(int)u-1,r)<0)
+	  fprintf(stderr,"represent error: %s\n", strerror(errno));
+	for (s=buf, t=c_addr;; s++) {
+	  char c = *s;
+	  if ('0'<=c && c<='9')
+	    *t++ = c;
+	  else if (c != '.')
+	    break;
+	}
+	/* fprintf(stderr,"r=%.*e, t=%p, c_addr=%p, u=%ld\n",(int)u-1,r,t,c_addr,u);*/
+	assert(t == c_addr+u);
+	assert(*s == 'e');
 	s++;
-      decpt = atoi(s)+1;
+	if (*s == '+')
+	  s++;
+	decpt = atoi(s)+1;
+      }
     }
   }
   *np = decpt;
@@ -670,6 +684,25 @@ struct Cellpair represent(Float r, Address c_addr1, UCell u, Cell *np)
   return fs;
 }
 
+struct Cellpair represent_shortest(Float r, Address c_addr, UCell u, Cell *np, UCell *lenp)
+{
+  char sbuf[DTOA_SHORTEST_MAX];
+  int slen, sdecpt;
+  struct Cellpair fs;
+  if (isfinite(r) && r != 0.0 && u > 0 &&
+      (slen = dtoa_shortest(fabs(r), sbuf, &sdecpt)) <= u) {
+    memcpy(c_addr, sbuf, slen);
+    *np = sdecpt;
+    *lenp = slen;
+    fs.n1 = FLAG(signbit(r)!=0);
+    fs.n2 = -1;
+    return fs;
+  }
+  fs = represent(r, c_addr, u, np);
+  *lenp = (r == 0.0 && u > 0) ? 1 : u;
+  return fs;
+}
+
 Cell to_float(Char *c_addr, UCell u, Float *rp, Char dot)
 {
   /* convertible string := <significand>[<exponent>]
@@ -690,7 +723,12 @@ Cell to_float(Char *c_addr, UCell u, Float *rp, Char dot)
   char *t=cnum;
   char *endconv;
   Float r;
-  
+
+  switch (fast_to_float(c_addr, u, rp, dot)) {
+  case 1: return -1;
+  case 0: goto error;
+  }
+  /* slow path: let strtod() do it */
   if (s >= send) /* treat empty string as 0e */
     goto return0;
   switch ((c=*s)) {
@@ -1153,6 +1191,67 @@ DCell fmdiv (DCell num, Cell denom)
 }
 #endif
 
+static const char digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+static const char hex_digits[] = "0123456789ABCDEF";
+
+Char *ucell_digits(UCell u, Char *end, UCell base)
+/* Store the digits of u in base (>=2) in the chars before end, the
+   same digits as produced by #; return the address of the first
+   digit.  Bases 10 and 16 convert four and two digits per step; the
+   divisions by constants become multiplications by reciprocals. */
+{
+  if (base == 10) {
+    while (u >= 10000) {
+      UCell q = u / 10000;
+      unsigned r = u - q * 10000;
+      end -= 4;
+      memcpy(end, digit_pairs + 2 * (r / 100), 2);
+      memcpy(end + 2, digit_pairs + 2 * (r % 100), 2);
+      u = q;
+    }
+    if (u >= 100) {
+      unsigned r = u % 100;
+      end -= 2;
+      memcpy(end, digit_pairs + 2 * r, 2);
+      u /= 100;
+    }
+    if (u >= 10) {
+      end -= 2;
+      memcpy(end, digit_pairs + 2 * u, 2);
+    } else
+      *--end = '0' + u;
+  } else if (base == 16) {
+    while (u >= 0x100) {
+      end -= 2;
+      end[0] = hex_digits[(u >> 4) & 0xf];
+      end[1] = hex_digits[u & 0xf];
+      u >>= 8;
+    }
+    if (u >= 0x10) {
+      *--end = hex_digits[u & 0xf];
+      u >>= 4;
+    }
+    *--end = hex_digits[u];
+  } else {
+    do {
+      UCell d = u % base;
+      *--end = d < 10 ? '0' + d : 'A' - 10 + d;
+      u /= base;
+    } while (u != 0);
+  }
+  return end;
+}
+
 DCell utf8_fetch_plus(Char * c_addr, UCell len)
 /* Read utf8 and increment */
 {
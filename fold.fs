@@ -161,6 +161,8 @@ optimizes fpick
     drop lits# 1 = if
         lits> case
             0    of postpone drop 0 lit, endof
+            1    of endof
+            -1   of postpone negate endof
             2    of postpone 2*    endof
             cell of postpone cells endof
             dup pow2? ?of log2 lit, postpone lshift endof
@@ -171,6 +173,53 @@ optimizes fpick
     then ;
 ' opt* optimizes *
 
+\ optimize shifts, and, or, xor with one literal: remove identities,
+\ and replace absorbing literals
+
+: opt-shift ( xt -- )
+    lits# 1 = if
+	lits> dup 0= if  2drop exit  then  >lits
+    then
+    fold2-1 ;
+' opt-shift optimizes lshift
+' opt-shift optimizes rshift
+' opt-shift optimizes arshift
+' opt-shift optimizes rol
+' opt-shift optimizes ror
+
+: opt-and ( xt -- )
+    lits# 1 = if
+	lits> case
+	    -1 of drop exit endof
+	    0  of drop postpone drop 0 lit, exit endof
+	    dup >lits
+	endcase
+    then
+    fold2-1 ;
+' opt-and optimizes and
+
+: opt-or ( xt -- )
+    lits# 1 = if
+	lits> case
+	    0  of drop exit endof
+	    -1 of drop postpone drop -1 lit, exit endof
+	    dup >lits
+	endcase
+    then
+    fold2-1 ;
+' opt-or optimizes or
+
+: opt-xor ( xt -- )
+    lits# 1 = if
+	lits> case
+	    0  of drop exit endof
+	    -1 of drop postpone invert exit endof
+	    dup >lits
+	endcase
+    then
+    fold2-1 ;
+' opt-xor optimizes xor
+
 : opt-array>mem ( xt -- )
     drop lits# 1 = if
         lits> dup ]] literal * literal [[
@@ -0,0 +1,122 @@
+\ automatic inlining of short colon definitions
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ We do not decompile threaded code; instead, while a colon
+\ definition is compiled, every COMPILE, performed by the text
+\ interpreter is recorded, together with the literals pushed on the
+\ literal stack before it.  If nothing else was compiled (i.e., HERE
+\ only changed in these COMPILE,s), the definition is straight-line
+\ code, and compiling the definition can be replaced by replaying the
+\ recording in the caller; the dynamic superinstructions then span
+\ the inlined code, and literals of the caller are folded with the
+\ inlined code.  Control structures, DOES>, quotations, locals, TO,
+\ recursion and words that use the return stack or the locals stack
+\ prevent inlining.
+
+#3 Value inline-auto ( -- u ) \ gforth-experimental
+\G Colon definitions that compile at most @i{u} words (and otherwise
+\G qualify for @code{inline}) are inlined automatically; 0 disables
+\G automatic inlining.
+
+Variable inline-sp     \ stack depth at the start of the definition
+Variable inline-here   \ HERE after the last recorded word; 0: no inlining
+Variable inline-lits   \ literals left on the literal stack by it
+Variable inline-nest   \ nesting depth of COMPILE,
+Variable inline-#words \ number of recorded words
+Variable inline-ok     \ the last definition can be inlined
+Variable inline-last   \ its xt
+$Variable inline-code  \ the recording: u, u literals, xt (0 at the end)
+
+Create inline-bad ( -- addr ) \ words that cannot be inlined
+' ;s , ' execute-;s , ' >r , ' r> , ' r@ , ' i , ' r'@ , ' rpick ,
+' rpick# , ' rdrop , ' 2>r , ' 2r> , ' 2r@ , ' 2rdrop , ' j , ' k ,
+' i' , ' delta-i , ' unloop , ' rp@ , ' rp! , ' lp@ , ' lp! , ' >l ,
+' f>l , ' lp+! , ' lp+ , ' lp- ,
+here inline-bad - cell/ Constant #inline-bad
+
+: inline-bad? ( xt -- f )
+    dup latestxt = IF  drop true  EXIT  THEN \ recursion
+    inline-bad #inline-bad cells bounds ?DO
+	dup I @ = IF  drop true  UNLOOP EXIT  THEN
+    cell +LOOP  drop false ;
+
+: cell+code ( x -- )  {: w^ x :} x cell inline-code $+! ;
+
+: inline-lits+ ( -- )
+    \ record the literals pushed since the last recorded word
+    lits# inline-lits @ - cell+code
+    litstack $@ inline-lits @ cells /string inline-code $+! ;
+
+: inline-record ( xt -- )
+    inline-here @ here <>  lits# inline-lits @ u< or
+    over inline-bad? or IF  drop inline-here off  EXIT  THEN
+    inline-lits+ cell+code  1 inline-#words +! ;
+
+:noname ( xt -- )
+    inline-here @ 0<> inline-nest @ 0= and IF  dup inline-record  THEN
+    1 inline-nest +!  defers compile,  -1 inline-nest +!
+    inline-here @ 0<> inline-nest @ 0= and IF
+	here inline-here !  lits# inline-lits !  THEN ; is compile,
+
+: inline-start ( -- )
+    depth inline-sp !  here inline-here !  lits# inline-lits !
+    inline-nest off  inline-#words off  inline-ok off  inline-last off
+    s" " inline-code $! ;
+
+: inline-:-hook ( -- )
+    \ a definition inside a definition prevents inlining the outer one
+    inline-here @ IF  depth inline-sp @ u> IF  inline-here off  EXIT  THEN  THEN
+    inline-start ;
+
+: inline-;-hook ( -- )
+    inline-here @ 0= ?EXIT  depth inline-sp @ <> ?EXIT
+    inline-here @ here =  lits# inline-lits @ u>= and  locals-list @ 0= and
+    IF  inline-lits+ 0 cell+code  true inline-ok !  THEN
+    inline-here off ;
+
+: inline-compile, ( xt -- )
+    \ replay the recording of xt
+    >extra @ dup cell+ swap @ bounds BEGIN  2dup u>  WHILE
+	    dup @ >r cell+ r> 0 ?DO  dup @ >lits cell+  LOOP
+	    dup @ ?dup-IF  compile,  THEN  cell+
+    REPEAT  2drop ;
+
+: (inline) ( -- )
+    align here  inline-code $@ dup , here over allot swap move
+    ?hm hmtemplate >hmextra !  ['] inline-compile, set-optimizer ;
+
+: inline-;-hook2 ( -- )
+    inline-ok @ 0= ?EXIT  inline-ok off  latestxt inline-last !
+    inline-#words @ inline-auto u<= IF  (inline)  THEN ;
+
+:noname defers :-hook  inline-:-hook ; is :-hook
+:noname inline-;-hook  defers ;-hook ; is ;-hook
+:noname defers ;-hook2  inline-;-hook2 ; is ;-hook2
+
+: inline ( -- ) \ gforth-experimental
+    \G Make the last definition, a colon definition, an inlined word:
+    \G compiling it compiles the words (and literals) it consists of
+    \G instead of a call.  This is possible for straight-line
+    \G definitions without control structures, locals, quotations,
+    \G recursion, or words that access the return stack (including
+    \G @code{exit} in the middle).
+    latestxt inline-last @ <> abort" cannot inline this definition"
+    latestxt >namehm @ >hmcompile, @ ['] inline-compile, = ?EXIT
+    (inline) ;
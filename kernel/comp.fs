@@ -345,6 +345,8 @@ has? primcentric [IF]
     has? peephole [IF]
 	defer prim-check ( xt -- xt ) ' noop is prim-check
 	\ hook for stack depth (and maybe later type) checker
+	defer dyncode-hook ( -- ) ' noop is dyncode-hook
+	\ hook called after generating native code (see perfmap.fs)
 
 	: peephole-compile, ( xt -- )
 	    \ compile xt, appending its code to the current dynamic superinstruction
@@ -354,7 +356,7 @@ has? primcentric [IF]
 	    codestart @ here aligned over -
 	    dup cell/ dup primbits $bit 2drop targets $bit 2drop
 	    primbits $@ drop targets $@ drop
-	    compile-prims
+	    compile-prims dyncode-hook
 	    primbits $free targets $free
 	    here aligned codestart ! ;
     [ELSE]
@@ -934,12 +934,16 @@ Defer 'cold ( -- ) \ gforth  tick-cold
     os-cold
 [ [THEN] ]
 [ has? os [IF] ]
+    obuf off  obuf# off
     set-encoding-fixed-width
     'cold
 [ [THEN] ]
 [ has? file [IF] ]
     process-args
     loadline off
+[ [THEN] ]
+[ has? os [IF] ]
+    obuf-flush
 [ [THEN] ]
     -56 (bye) ; \ indicate QUIT
 
@@ -997,7 +1001,7 @@ Defer bye
 [ [ELSE] ]
     cr
 [ [THEN] ]
-    0 (bye) ;
+    obuf-flush  0 (bye) ;
 ' kernel-bye is bye
 [THEN]
 
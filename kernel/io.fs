@@ -45,22 +45,97 @@ User out ( -- addr ) \ gforth
 \g characters, or the existence of Unicode characters with width 0 and
 \g 2, so it only works for simple cases.
 
+\ Output buffer
+
+has? os [IF]
+User obuf-size ( -- a-addr ) \ gforth
+\G User variable containing the size of the output buffer of the
+\G current task; 0 (the default) means that @code{type} and
+\G @code{emit} write directly to @code{outfile-id}.  Change it with
+\G @code{set-obuf}.
+0 obuf-size !
+User obuf-latency ( -- a-addr ) \ gforth
+\G User variable containing the maximum time in ns that output stays
+\G in the output buffer, checked whenever more output is buffered.
+#10000000 obuf-latency !
+User obuf      \ the output buffer of the current task, or 0
+User obuf#     \ number of chars in the output buffer
+User obuf-fid  \ the file-id the buffered output is for
+User obuf-deadline \ low cell of the ntime when the buffer is due
+0 obuf !  0 obuf# !
+
+: obuf-flush ( -- ) \ gforth
+    \G Write the output buffered by @code{type} and @code{emit} to its
+    \G file.  This happens automatically when the buffer is full, when
+    \G the buffered output gets older than @code{obuf-latency}, before
+    \G waiting for a key, before sleeping (@code{ms}, @code{ns},
+    \G @code{stop}), before writing to @code{debug-fid}, before closing
+    \G its file or leaving @code{outfile-execute}, and on @code{bye}.
+    obuf# @ IF
+	obuf @ obuf# @ obuf-fid @ write-file drop  obuf# off
+	obuf-fid @ flush-file drop
+    THEN ;
+
+: set-obuf ( u -- ) \ gforth
+    \G Flush the output buffer of the current task and give it the size
+    \G @i{u}; 0 switches output buffering off.
+    obuf-flush  obuf @ ?dup-IF  free throw  obuf off  THEN
+    obuf-size ! ;
+
+: obuf-room ( u -- f ) \ gforth-internal
+    \ prepare to buffer @i{u} more chars; @i{f} is false if they do not fit
+    obuf-fid @ outfile-id <> IF  obuf-flush  outfile-id obuf-fid !  THEN
+    obuf @ 0= IF  obuf-size @ chars allocate throw obuf !  THEN
+    dup obuf# @ + obuf-size @ u> IF  obuf-flush  THEN
+    obuf-size @ u<= ;
+
+: obuf-append ( u -- c-addr ) \ gforth-internal
+    \ reserve @i{u} chars in the buffer
+    obuf# @ 0= IF  ntime drop obuf-latency @ + obuf-deadline !  THEN
+    obuf @ obuf# @ chars + swap obuf# +! ;
+
+: ?obuf-due ( -- ) \ gforth-internal
+    ntime drop obuf-deadline @ - 0< 0= IF  obuf-flush  THEN ;
+
+: obuf-type ( c-addr u -- ) \ gforth-internal
+    dup obuf-room IF
+	dup obuf-append swap chars move  ?obuf-due
+    ELSE
+	outfile-id write-file drop
+    THEN ;
+
+: obuf-emit ( c -- ) \ gforth-internal
+    1 obuf-room drop  1 obuf-append c!  ?obuf-due ;
+[THEN]
+
+has? file [IF]
+: close-file ( wfileid -- wior ) \ file
+    \G Close the file @i{wfileid}; output buffered for it is written
+    \G first.
+    [ has? os [IF] ] dup obuf-fid @ = IF  obuf-flush  THEN [ [THEN] ]
+    (close-file) ;
+[THEN]
+
 : (type) ( c-addr u -- )
     dup out +!
+    [ has? os [IF] ] obuf-size @ IF  obuf-type  EXIT  THEN [ [THEN] ]
     outfile-id write-file drop \ !! use ?DUP-IF THROW ENDIF instead of DROP ?
 ;
 
 : (emit) ( c -- )
     1 out +!
+    [ has? os [IF] ] obuf-size @ IF  obuf-emit  EXIT  THEN [ [THEN] ]
     outfile-id emit-file drop \ !! use ?DUP-IF THROW ENDIF instead of DROP ?
 ;
 
 : (err-type) ( c-addr u -- )
+    [ has? os [IF] ] obuf-flush [ [THEN] ]
     dup out +!
     debug-fid write-file drop \ !! use ?DUP-IF THROW ENDIF instead of DROP ?
 ;
 
 : (err-emit) ( c -- )
+    [ has? os [IF] ] obuf-flush [ [THEN] ]
     1 out +!
     debug-fid emit-file drop \ !! use ?DUP-IF THROW ENDIF instead of DROP ?
 ;
@@ -81,9 +156,11 @@ User out ( -- addr ) \ gforth
     dup 0< IF  throw  THEN  nip ;
 
 : (key) ( -- c / ior )
+    [ has? os [IF] ] obuf-flush [ [THEN] ]
     infile-id (key-file) ;
 
 : (key?) ( -- flag )
+    [ has? os [IF] ] obuf-flush [ [THEN] ]
     infile-id key?-file ;
 
 user-o op-vector
@@ -264,6 +341,7 @@ Defer deadline ( d -- )
     2drop ;
 ' kernel-deadline IS deadline
 : ns ( d -- ) \ gforth
+    [ has? os [IF] ] obuf-flush [ [THEN] ]
     ntime d+ deadline ;
 : ms ( n -- ) \ facility-ext
     #1000000 um* ns ;
@@ -24,6 +24,7 @@ here
 ' heap-allocate a,
 ' heap-free a,
 ' heap-resize a,
+' heap-allocation-size a,
 A, here Aconstant heap-words
 
 uval-o current-memory-words
@@ -52,4 +53,10 @@ umethod resize	( a_addr1 u -- a_addr2 wior )	\ memory
     \G fails, @i{wior} is a non-zero I/O result code. If @i{a-addr1}
     \G is 0, Gforth's (but not the Standard) @code{resize}
     \G @code{allocate}s @i{u} address units.
+
+umethod allocation-size ( a_addr -- u ) \ gforth-experimental
+    \G @i{u} is the number of address units that can be used in the
+    \G region at @i{a-addr} (obtained with @code{allocate} or
+    \G @code{resize}); this may be more than was asked for, and is 0
+    \G if unknown.
 2drop
@@ -87,9 +87,11 @@ require ./io.fs
     \G convert at least one digit. Therefore, if @var{ud} is 0,
     \G @code{#s} will prepend a ``0'' to the pictured numeric output
     \G string.
-    BEGIN
-	# 2dup or 0=
-    UNTIL ;
+    BEGIN  dup WHILE  #  REPEAT \ until the rest fits in a cell
+    \ convert the rest in one go unless the hold area may overflow
+    holdptr @ dup holdbuf - [ 8 cells ] Literal u<  base @ 2 u< or IF
+	drop BEGIN  # 2dup or 0=  UNTIL  EXIT  THEN
+    rot base @ rot (u#s) holdptr !  0 ;
 
 : holds ( addr u -- ) \ core-ext
     \G Used between @code{<<#} and @code{#>}. Prepend the string @code{addr u}
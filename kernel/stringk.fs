@@ -61,14 +61,28 @@
 : $@len ( $addr -- u ) \ gforth string-fetch-len
     \G returns the length of the stored string.
     @ dup IF  @  THEN ;
+: $keep? ( u $buf -- flag )
+    \ $buf has room for u bytes, and u grows the string or does not
+    \ shrink the buffer to less than a quarter
+    2dup @ u>= >r  allocation-size swap $padding
+    2dup u>= -rot 2 lshift u<= r> or and ;
 : $!len ( u $addr -- ) \ gforth string-store-len
     \G changes the length of the stored string.  Therefore we must
     \G change the memory area and adjust address and count cell as
     \G well.
     over $padding  over @ IF  \ fast path for unneeded size change
 	over @ @ $padding over = IF  drop @ !  EXIT  THEN
+	2 pick 2 pick @ $keep?   IF  drop @ !  EXIT  THEN
     THEN
     over @ swap resize throw over ! @ ! ;
+: $reserve ( u $addr -- ) \ gforth string-reserve
+    \G make room for a string of @i{u} bytes at @i{$addr}, so that
+    \G growing the string up to this length does not resize the
+    \G buffer.  The string itself is not changed.
+    >r $padding r@ @ IF
+	r@ @ allocation-size over u>= IF  rdrop drop  EXIT  THEN
+	r@ @ swap resize throw r> !  EXIT  THEN
+    allocate throw 0 over ! r> ! ;
 : $! ( addr1 u $addr -- ) \ gforth string-store
     \G stores a newly allocated string buffer at an address,
     \G frees the previous buffer if necessary.
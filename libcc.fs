@@ -960,12 +960,17 @@ tmp$ $execstr-ptr !
     lib-filename $@ basename type ." .la"
     c-libs $.  c-libs $free ;
 
+Variable libcc-hits   \ libraries found with the right hash, for metrics.fs
+Variable libcc-misses \ libraries that had to be compiled
+:noname defers 'image  libcc-hits off  libcc-misses off ; is 'image
+
 : init-lib ( handle -- )
     s" gforth_libcc_init" rot lib-sym  ?dup-if
 	gforth-pointers swap call-c  endif ;
 : compile-wrapper-function1 ( -- )
     hash-c-source open-wrappers dup lib-handle!
     0= if
+	1 libcc-misses +!
 	c-library-name-create
 	libcc$ $@ c-source-file write-file throw  libcc$ $free
 	c-source-file close-file throw
@@ -983,6 +988,8 @@ tmp$ $execstr-ptr !
 	    THEN
 	endif
 	( lib-handle ) lib-handle!
+    else
+	1 libcc-hits +!
     endif
     host? IF  lib-handle init-lib  THEN
     lib-filename $free clear-libs ;
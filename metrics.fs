@@ -0,0 +1,126 @@
+\ runtime metrics
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ A metric is a named number that is computed when it is asked for,
+\ either for the whole system or for every running task.  .metrics
+\ shows them in the text format of Prometheus, one "name value" line
+\ each (per-task metrics get a task label), and metrics-server
+\ answers HTTP requests with this text, for monitoring systems.
+
+require unix/pthread.fs
+require unix/socket.fs
+
+Variable metrics \ list: link, xt, per-task flag, name
+
+: (metric) ( xt c-addr u flag -- )
+    {: xt d: name flag :}
+    align here  0 , xt , flag , name string,
+    metrics BEGIN  dup @  WHILE  @  REPEAT  ! ;
+
+: metric ( xt "name" -- ) \ gforth-experimental
+    \G Add the metric @i{name}; @i{xt} ( -- n ) computes its current
+    \G value.
+    parse-name false (metric) ;
+
+: task-metric ( xt "name" -- ) \ gforth-experimental
+    \G Add the metric @i{name}, which has a value for every running
+    \G task; @i{xt} ( task -- n ) computes the current value for
+    \G @i{task}.
+    parse-name true (metric) ;
+
+: metric-name ( metric -- c-addr u )  3 cells + count ;
+
+: find-metric ( c-addr u -- metric )
+    metrics BEGIN  @ dup  WHILE
+	    >r 2dup r@ metric-name str= r> swap  UNTIL  nip nip
+    ELSE  -13 throw  THEN ;
+
+: metric@ ( c-addr u -- n ) \ gforth-experimental metric-fetch
+    \G @i{n} is the current value of the metric named @i{c-addr u}
+    \G (for a per-task metric: the value for the current task).
+    find-metric dup 2 cells + @ IF  up@ swap  THEN  cell+ perform ;
+
+: .metric-task ( metric task -- metric )
+    over metric-name type  .\" {task=\""
+    dup [: 0 u.r ;] $10 base-execute  .\" \"} "
+    over cell+ perform 0 .r cr ;
+
+: .metric ( metric -- )
+    dup 2 cells + @ IF  ['] .metric-task map-tasks drop  EXIT  THEN
+    dup metric-name type space  cell+ perform 0 .r cr ;
+
+: .metrics ( -- ) \ gforth-experimental dot-metrics
+    \G Show the current values of all metrics, one per line (for
+    \G per-task metrics: one line per running task).
+    metrics BEGIN  @ dup  WHILE  dup .metric  REPEAT  drop ;
+
+\ the built-in metrics
+
+[: here forthstart - ;] metric dictionary_bytes
+' unused metric dictionary_unused_bytes
+
+: engine-metrics ( -- )
+    \ a metric for each of (engine-metric)
+    0 BEGIN  dup (engine-metric) dup  WHILE
+	    rot drop  third [{: u :}d u (engine-metric) 2drop ;]
+	    -rot false (metric)  1+
+    REPEAT  2drop 2drop ;
+engine-metrics
+
+[: closures-allocated @ ;] metric heap_closures_allocated
+[: closures-freed @ ;] metric heap_closures_freed
+[: libcc-hits @ ;] metric libcc_cache_hits
+[: libcc-misses @ ;] metric libcc_cache_misses
+' event-depth task-metric event_queue_depth
+[: stacks-used 2drop drop ;] task-metric data_stack_used_bytes
+[: stacks-used 2drop nip ;] task-metric return_stack_used_bytes
+[: stacks-used drop nip nip ;] task-metric fp_stack_used_bytes
+[: stacks-used nip nip nip ;] task-metric locals_stack_used_bytes
+
+\ serving the metrics over HTTP
+
+Create metrics-request $100 allot
+
+: skip-request ( socket -- )
+    \ read the HTTP request up to the empty line ending the header
+    >r  BEGIN  metrics-request $100 r@ read-line throw  WHILE
+	    1 u<=  UNTIL  ELSE  drop  THEN  rdrop ;
+
+: answer-metrics ( socket -- )
+    dup skip-request >r
+    s\" HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n\r\n"
+    r@ write-socket
+    ['] .metrics >string-execute 2dup r> write-socket  drop free throw ;
+
+: create-local-server ( port -- server )
+    \ like create-server, but only reachable from this host
+    AF_INET port+family  $7F000001 lbe sockaddr-tmp sin_addr l!
+    new-socket dup ?ior dup >r reuse-addr
+    r@ sockaddr-tmp sockaddr_in4 bind ?ior r> ;
+
+: metrics-server ( port -- ) \ gforth-experimental
+    \G Start a task that answers every HTTP request to TCP port
+    \G @i{port} of the loopback interface with the output of
+    \G @code{.metrics}, e.g., for @code{curl localhost:}@i{port}.
+    create-local-server dup 4 listen
+    [{: server :}h1
+	BEGIN  server accept-socket
+	    dup ['] answer-metrics catch IF  drop  THEN  close-socket
+	AGAIN ;] execute-task drop ;
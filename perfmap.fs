@@ -0,0 +1,46 @@
+\ name dynamically generated native code for native profilers
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ With the engine options --perf-map or --jitdump, every piece of
+\ native code generated for a primitive or superinstruction is
+\ reported to the engine (engine/perfmap.c) with a name consisting of
+\ the word that contains it and the primitive(s), e.g. "fib lit+".
+
+[IFDEF] next-dyncode
+
+: .dyncode-name ( c-addr u a-tc -- )
+    cell+ >bt-entry ?dup-IF  .name  ELSE  ." [code] "  THEN  type ;
+
+: perf-map-piece ( a-tc -- )
+    dup decompile-prim3 { a-tc seqlen start end c-addr u len }
+    seqlen 0= len 0<= or IF  EXIT  THEN
+    a-tc @ len  c-addr u a-tc ['] .dyncode-name >string-execute
+    2dup 2>r (perf-map-region) 2r> drop free throw
+    IF  ['] noop is dyncode-hook  THEN ; \ cannot write the files
+
+: perf-map-flush ( -- )
+    \ report the native code generated since the last call
+    perf-map-flags 0= IF  EXIT  THEN
+    BEGIN  next-dyncode ?dup-WHILE  perf-map-piece  REPEAT ;
+
+' perf-map-flush is dyncode-hook
+:noname ( -- )  defers 'cold  perf-map-flush ; is 'cold
+
+[THEN]
@@ -0,0 +1,191 @@
+\ size-class pools and arenas behind ALLOCATE, FREE and RESIZE
+
+\ Authors: Bernd Paysan, Anton Ertl
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ Loading this file replaces the methods of heap-words (the memory
+\ words of all tasks, see kernel/memory.fs) with pool-allocate,
+\ pool-free, pool-resize and pool-allocation-size.  Small blocks come
+\ from per-task free lists for a few size classes, so allocating and
+\ freeing them needs neither malloc nor a lock; the lists are refilled
+\ by cutting a chunk into blocks.  When a task ends, its lists are handed over to global
+\ lists, which the next task that runs out of blocks takes over.
+\ Large blocks are still allocated with heap-allocate.
+
+\ Every block from a pool or an arena has two header cells: a tag
+\ (the block address xor a key) and the size class (pools) or the size
+\ (arenas).  FREE and RESIZE pass blocks with a different tag (e.g.,
+\ from malloc, or from an outer arena) on.
+
+require unix/pthread.fs
+
+6 Constant #pool-classes \ payload sizes 2 cells, 4 cells, ..., 64 cells
+
+$10000 Value pool-chunk ( -- u ) \ gforth-experimental
+\G The number of aus of the chunks that @code{allocate} cuts into
+\G small blocks.
+
+Variable pool-key  utime drop here xor pool-key !
+Create pool-orphans #pool-classes cells allot \ lists of ended tasks
+pool-orphans #pool-classes cells erase
+
+User pool-up    \ the task that owns pool-lists
+User pool-lists #pool-classes cells cell- uallot drop
+
+: pool-tag ( a_addr -- x )  pool-key @ xor ;
+: pool-size ( class -- u )  2 cells swap lshift ;
+: pool-list ( class -- addr )  cells pool-lists + ;
+
+: pool-class ( u -- class )
+    \ the smallest class for u aus; #pool-classes if none is large enough
+    #pool-classes 0 ?DO
+	dup I pool-size u<= IF  drop I UNLOOP EXIT  THEN
+    LOOP  drop #pool-classes ;
+
+: ?pool-task ( -- )
+    \ the user area of a new task is a copy, so it does not own the lists
+    pool-up @ up@ = ?EXIT
+    pool-lists #pool-classes cells erase  up@ pool-up ! ;
+
+: pool-block? ( a_addr -- f )
+    dup 0= ?EXIT  dup 2 cells - @ swap pool-tag = ;
+
+: pool-refill ( class -- wior )
+    \ take over the orphaned list of class, or cut a new chunk
+    {: c :}  0 c cells pool-orphans + !@ ?dup-IF  c pool-list !  0 EXIT  THEN
+    c pool-size 2 cells + {: bsize :}
+    pool-chunk heap-allocate ?dup-IF  nip  EXIT  THEN
+    dup pool-chunk + bsize - 1+ swap ?DO
+	I 2 cells + pool-tag I !  c I cell+ !
+	c pool-list @ I 2 cells + !  I 2 cells + c pool-list !
+    bsize +LOOP  0 ;
+
+: pool-allocate ( u -- a_addr wior )
+    dup pool-class dup #pool-classes = IF  drop heap-allocate  EXIT  THEN
+    nip {: c :}  ?pool-task
+    c pool-list @ 0= IF  c pool-refill ?dup-IF  0 swap  EXIT  THEN  THEN
+    c pool-list @ dup @ c pool-list !  0 ;
+
+: pool-free ( a_addr -- wior )
+    dup pool-block? 0= IF  heap-free  EXIT  THEN
+    ?pool-task  dup cell- @ pool-list tuck @ over !  swap !  0 ;
+
+: pool-resize ( a_addr1 u -- a_addr2 wior )
+    over 0= IF  nip pool-allocate  EXIT  THEN
+    over pool-block? 0= IF  heap-resize  EXIT  THEN
+    over cell- @ pool-size over u>= IF  drop 0  EXIT  THEN
+    {: a1 u :}  u pool-allocate ?dup-IF  nip a1 swap  EXIT  THEN
+    a1 over a1 cell- @ pool-size move  a1 pool-free drop  0 ;
+
+: pool-allocation-size ( a_addr -- u )
+    dup pool-block? IF  cell- @ pool-size  EXIT  THEN  heap-allocation-size ;
+
+: pool-orphan1 ( first class -- )
+    \ push the list starting with first on the global list of class
+    cells pool-orphans + {: first a :}
+    first BEGIN  dup @ ?dup-WHILE  nip  REPEAT {: last :}
+    BEGIN  a @ dup last !  first over a ?!@ =  UNTIL ;
+
+: pool-orphan ( -- )
+    \ hand the lists of the ending task over to the global lists
+    #pool-classes 0 ?DO
+	I pool-list @ ?dup-IF  I pool-orphan1  THEN
+    LOOP  pool-lists #pool-classes cells erase ;
+
+:noname pool-up @ up@ = IF  pool-orphan  THEN  defers kill-task ;
+is kill-task
+
+:noname defers 'image
+    pool-up off  pool-orphans #pool-classes cells erase ; is 'image
+
+heap-words cell- @
+' pool-allocate over !  ' pool-free over cell+ !  ' pool-resize over 2 cells + !
+' pool-allocation-size swap 3 cells + !
+
+\ arenas
+
+\ An arena is an object for current-memory-words: the cell before it
+\ points to arena-methods, then come the outer memory words, the list
+\ of chunks, the next free address and the end of the current chunk.
+\ The tag of an arena block includes the arena, so blocks of outer
+\ arenas are passed on, too.
+
+$4000 Value arena-chunk ( -- u ) \ gforth-experimental
+\G The minimal number of aus that an arena allocates from the heap at
+\G a time.
+
+: arena-tag ( a_addr arena -- x )  xor pool-key @ invert xor ;
+
+: arena-block? ( a_addr -- f )
+    dup 0= ?EXIT  dup 2 cells - @ swap current-memory-words arena-tag = ;
+
+: arena-outer ( ... xt -- ... )
+    \ execute xt with the memory words outside the current arena
+    current-memory-words dup @ to current-memory-words
+    >r catch r> to current-memory-words throw ;
+
+: arena-grow ( u arena -- wior )
+    \ add a chunk with room for u aus to arena
+    {: u o :}  u arena-chunk max cell+ dup heap-allocate ?dup-IF  nip nip  EXIT  THEN
+    o cell+ @ over !  dup o cell+ !
+    cell+ dup o 2 cells + !  + cell- o 3 cells + !  0 ;
+
+: arena-allocate ( u -- a_addr wior )
+    current-memory-words {: u o :}  u 2 cells + aligned {: n :}
+    o 2 cells + @ n + o 3 cells + @ u> IF
+	n o arena-grow ?dup-IF  0 swap  EXIT  THEN  THEN
+    o 2 cells + @ dup n + o 2 cells + !  2 cells +
+    dup o arena-tag over 2 cells - !  u over cell- !  0 ;
+
+: arena-free ( a_addr -- wior )
+    dup arena-block? IF  drop 0  EXIT  THEN  ['] free arena-outer ;
+
+: arena-resize ( a_addr1 u -- a_addr2 wior )
+    over 0= IF  nip arena-allocate  EXIT  THEN
+    over arena-block? 0= IF  ['] resize arena-outer  EXIT  THEN
+    over cell- @ over u>= IF  drop 0  EXIT  THEN
+    {: a1 u :}  u arena-allocate ?dup-IF  nip a1 swap  EXIT  THEN
+    a1 over a1 cell- @ move  0 ;
+
+: arena-allocation-size ( a_addr -- u )
+    dup arena-block? IF  cell- @  EXIT  THEN  ['] allocation-size arena-outer ;
+
+Create arena-methods
+' arena-allocate , ' arena-free , ' arena-resize , ' arena-allocation-size ,
+
+: arena{ ( -- ) \ gforth-experimental arena-brace
+    \G Until the matching @code{@}arena}, @code{allocate} and
+    \G @code{resize} in the current task take memory from a new arena,
+    \G and @code{free} does nothing for memory from this arena.
+    5 cells heap-allocate throw  arena-methods over !  cell+ {: o :}
+    current-memory-words o !  o cell+ 3 cells erase
+    o to current-memory-words ;
+
+: }arena ( -- ) \ gforth-experimental brace-arena
+    \G Free all memory allocated from the innermost arena at once, and
+    \G use the memory words from before @code{arena@{} again.
+    current-memory-words {: o :}
+    o cell- @ arena-methods <> abort" }arena without arena{"
+    o cell+ @ BEGIN  dup  WHILE  dup @ swap heap-free throw  REPEAT  drop
+    o @ to current-memory-words  o cell- heap-free throw ;
+
+: arena-execute ( ... xt -- ... ) \ gforth-experimental
+    \G Execute @i{xt} between @code{arena@{} and @code{@}arena}, also
+    \G if @i{xt} throws.
+    arena{ catch }arena throw ;
+' arena-execute nonescaping
@@ -0,0 +1,235 @@
+\ Sampling profiler
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ The engine (sampler.c) records the ip, the machine pc and the return
+\ stack on every SIGPROF in a ring buffer.  Here we consume these
+\ samples: the words are found like in backtraces (>bt-entry), and the
+\ samples are counted per stack (for flame graphs) and per word (for
+\ .profile).
+
+#199 Value profile-hz ( -- u ) \ gforth-experimental
+\G Samples per second of CPU time taken after @code{profile-start}.
+
+$4000 Value profile-slots ( -- u ) \ gforth-experimental
+\G Number of samples the engine can hold before
+\G @code{profile-drain} consumes them; further samples are dropped.
+
+\ counting tables: open hashing, keys are strings
+
+3 cells Constant /count-entry \ $-string key, two counts
+
+: count-init ( ubits table -- )
+    \ table: entries, log2 of capacity, number of used entries
+    2dup cell+ !  0 over 2 cells + !
+    swap 1 swap lshift /count-entry * dup allocate throw
+    dup rot erase  swap ! ;
+
+: count-slot ( u table -- entry )
+    >r  1 r@ cell+ @ lshift 1- and /count-entry * r> @ + ;
+
+: count-find ( c-addr u table -- entry )
+    \ the entry for key c-addr u, or the free entry where it belongs
+    { d: key t }
+    key t cell+ @ (hashkey1)
+    BEGIN  dup t count-slot dup @  WHILE
+	    dup $@ key str= 0=  WHILE  drop 1+
+    REPEAT  THEN  nip ;
+
+: count-grow ( table -- )
+    dup @ over cell+ @ { t old bits }
+    bits 1+ t count-init
+    old 1 bits lshift /count-entry * bounds ?DO
+	I @ IF
+	    I $@ t count-find I swap /count-entry move
+	    1 t 2 cells + +!
+	THEN
+    /count-entry +LOOP
+    old free throw ;
+
+: count+ ( n1 n2 c-addr u table -- )
+    \ add n1 and n2 to the counts of key c-addr u
+    { t }  t @ 0= IF  8 t count-init  THEN
+    t 2 cells + @ 2* 1 t cell+ @ lshift u>= IF  t count-grow  THEN
+    2dup t count-find dup @ 0= IF
+	>r r@ $!  1 t 2 cells + +!  r>
+    ELSE  nip nip  THEN
+    tuck 2 cells + +!  cell+ +! ;
+
+: count-each ( xt table -- )
+    \ execute xt ( entry -- ) for every used entry
+    { xt t }  t @ 0= IF  EXIT  THEN
+    t @ 1 t cell+ @ lshift /count-entry * bounds ?DO
+	I @ IF  I xt execute  THEN
+    /count-entry +LOOP ;
+
+: count-free ( table -- )
+    ['] $free over count-each
+    dup @ free throw  0 swap ! ;
+
+Create folded-counts  0 , 0 , 0 , \ folded stack -> samples
+Create word-counts    0 , 0 , 0 , \ nt -> self samples, total samples
+Variable profile-samples
+Variable profile-unknown \ samples without any word
+
+\ symbolizing samples
+
+#32 Constant sample-cells \ SAMPLE_CELLS in engine/forth.h
+
+Create frames sample-cells cells allot \ nts, innermost first
+Variable #frames
+$Variable folded$
+
+: frame, ( nt -- )
+    frames #frames @ cells + !  1 #frames +! ;
+
+: ip>nt ( ip -- nt|0 )
+    \ the word whose threaded code contains ip
+    dup IF  cell+ >bt-entry  THEN ;
+
+: pc>nt ( c-addr -- nt|0 )
+    \ the word whose dynamically generated native code contains c-addr
+    dup IF  dyncode>tc ip>nt  THEN ;
+
+: sample>frames ( a-addr -- )
+    \ the pc is exact where it maps; otherwise guess from the ips
+    #frames off
+    dup 3 cells + @ pc>nt
+    ?dup-0=-IF  dup cell+ @ ip>nt  THEN
+    ?dup-0=-IF  dup 2 cells + @ ip>nt  THEN
+    ?dup-IF  frame,  THEN
+    dup @ 1- cells over 4 cells + +  swap 4 cells + ?DO
+	I @ >bt-entry ?dup-IF  frame,  THEN
+    cell +LOOP ;
+
+: folded+ ( c-addr u -- )
+    \ append a frame name; ";" separates frames in folded stacks
+    tuck folded$ $+!  folded$ $@ + over - swap bounds ?DO
+	I c@ ';' = IF  ':' I c!  THEN
+    LOOP ;
+
+: folded-line ( -- c-addr u )
+    \ the frames, outermost first, separated by ";"
+    s" " folded$ $!
+    #frames @ 0= IF  s" [unknown]" folded$ $+!  THEN
+    0 #frames @ 1- -[DO
+	frames I cells + @ name>string folded+
+	I IF  s" ;" folded$ $+!  THEN
+    -1 +LOOP  folded$ $@ ;
+
+: seen? ( x u addr -- f )
+    \ is x one of the u cells at addr?
+    swap cells bounds ?DO
+	dup I @ = IF  drop true  UNLOOP EXIT  THEN
+    cell +LOOP  drop false ;
+
+: word+ ( n1 n2 nt -- )
+    {: w^ nt :} nt cell word-counts count+ ;
+
+: profile-sample ( a-addr -- )
+    sample>frames  1 profile-samples +!
+    1 0 folded-line folded-counts count+
+    #frames @ 0= IF  1 profile-unknown +!  EXIT  THEN
+    1 1 frames @ word+
+    #frames @ 1 ?DO
+	frames I cells + @ dup I frames seen? IF
+	    drop  ELSE  0 1 rot word+  THEN
+    LOOP ;
+
+\ user interface
+
+: profile-drain ( -- ) \ gforth-experimental
+    \G Consume the samples taken so far.  In long profiling runs, call
+    \G this regularly, or the engine's sample buffer
+    \G (@code{profile-slots}) fills up and samples are dropped.
+    BEGIN  (sampler-next) ?dup-IF  profile-sample (sampler-release)  false
+    ELSE  true  THEN  UNTIL ;
+
+: profile-start ( -- ) \ gforth-experimental
+    \G Start taking @code{profile-hz} samples per second of CPU time.
+    profile-hz profile-slots (sampler-start) throw ;
+
+: profile-stop ( -- ) \ gforth-experimental
+    \G Stop taking samples, and consume the samples taken.
+    (sampler-stop) profile-drain ;
+
+: profile-reset ( -- ) \ gforth-experimental
+    \G Forget the samples consumed so far.
+    folded-counts count-free  word-counts count-free
+    profile-samples off  profile-unknown off ;
+
+: profile-execute ( ... xt -- ... ) \ gforth-experimental
+    \G Execute @i{xt}, taking samples.
+    profile-start catch profile-stop throw ;
+
+: .folded ( -- )
+    [: dup $@ type space cell+ @ 0 .r cr ;] folded-counts count-each ;
+
+: profile-folded ( c-addr u -- ) \ gforth-experimental
+    \G Write the samples consumed so far to the file @i{c-addr u} in
+    \G the folded-stacks format of flame graph tools: one line per
+    \G distinct stack, with the words from the outermost to the
+    \G innermost separated by @code{;} (a @code{;} in a word name is
+    \G replaced by @code{:}), followed by a space and the number of
+    \G samples.
+    w/o create-file throw >r
+    ['] .folded r@ outfile-execute
+    r> close-file throw ;
+
+$Variable entries$ \ cell array of word-counts entries
+
+: self@ ( entry -- u )  cell+ @ ;
+
+: entry> ( entry1 entry2 -- f )
+    \ does entry1 have more self samples (or, if equal, total samples)?
+    over self@ over self@ 2dup <> IF  > nip nip  EXIT  THEN  2drop
+    2 cells + @ swap 2 cells + @ swap > ;
+
+: sort-entries ( -- )
+    entries$ $@ bounds ?DO
+	I cell+ BEGIN  dup entries$ $@ + u<  WHILE
+		dup @ I @ entry> IF  dup @ I @ swap I ! over !  THEN
+	cell+ REPEAT  drop
+    cell +LOOP ;
+
+: .permille ( u -- )
+    \ u as percentage of all samples
+    #1000 profile-samples @ 1 max */
+    0 <<# '%' hold # '.' hold #s #> 7 over - spaces type #>> ;
+
+: .profile-entry ( entry -- )
+    dup self@ .permille  dup 2 cells + @ .permille  space
+    $@ drop @ dup name>string type
+    name>view ?dup-IF  space .sourceview  THEN ;
+
+: .profile ( u -- ) \ gforth-experimental dot-profile
+    \G Show the @i{u} words with the most samples (consumed so far):
+    \G the percentage of samples where the word was running itself,
+    \G the percentage where it was running or on the return stack,
+    \G and where the word was defined.
+    profile-samples @ 0 .r ."  samples"
+    profile-unknown @ ?dup-IF  ." , " 0 .r ."  without words"  THEN
+    (sampler-dropped) ?dup-IF  ." , " 0 .r ."  dropped"  THEN  cr
+    ."    self  total word" cr
+    s" " entries$ $!
+    [: {: w^ e :} e cell entries$ $+! ;] word-counts count-each
+    sort-entries
+    entries$ $@ rot cells umin bounds ?DO
+	I @ .profile-entry cr
+    cell +LOOP ;
@@ -63,10 +63,38 @@ is 'clean-maintask
     Defer dump-sections ' drop is dump-sections
 [THEN]
 
+$Variable image-options ( -- $addr ) \ gforth-experimental
+\G Engine options for code generation (e.g., @code{--ss-number=50
+\G --ss-greedy}) that @code{savesystem} stores in the image; when the
+\G image is started, they are used unless the command line gives
+\G these options.  At the start, @code{image-options} contains the
+\G options stored in the running image.
+
+: preamble-options ( -- c-addr u )
+    \ the options of the "#tune" line in the preamble, if any
+    preamble-start forthstart over - s\" \n#tune " search IF
+	7 /string 2dup #lf scan nip -
+    ELSE  2drop 0 0  THEN ;
+
+:noname defers 'cold  preamble-options image-options $! ; is 'cold
+:noname defers 'image  image-options off ; is 'image
+
+: write-preamble ( c-addr u fid -- )
+    \ the "#! " line of the running image, a "#tune" line with the
+    \ options c-addr u, padding, and the magic
+    {: d: opts fid :}
+    preamble-start dup forthstart over - #lf scan drop over - 1+
+    fid write-file throw
+    opts nip IF  s" #tune " fid write-file throw  opts fid write-line throw  THEN
+    fid file-position throw drop 8 mod 8 swap ?DO  bl fid emit-file throw  LOOP
+    forthstart 8 - 8 fid write-file throw ;
+
 : dump-fi ( c-addr u -- )
+    image-options $@ save-mem 2>r \ 'image clears image-options
     prepare-for-dump
     w/o bin create-file throw >r
-    preamble-start here over - r@ write-file throw
+    2r@ r@ write-preamble  2r> drop free throw
+    forthstart here over - r@ write-file throw
     r@ dump-sections
     r> close-file throw ;
 
@@ -234,3 +234,38 @@ constant staged/-size ( -- u ) \ gforth staged-slash-size
         >lits then
     fold2-2 ;
 ' opt-u/mod optimizes u/mod
+
+\ symmetric division: the unsigned quotient of the absolute value,
+\ negated for negative dividends
+
+: lit/s, ( divisor -- )
+    \ compile ( n -- n/divisor ) with symmetric division, divisor>1
+    dup pow2? if
+        dup 1- ]] dup 0< literal and + [[ ctz ]] literal arshift [[ exit then
+    ]] dup abs [[ ['] u/-stage1m ['] u/-stage2m lit/,
+    ]] swap 0< tuck xor swap - [[ ;
+
+: opt-/s ( xt -- )
+    lits# 1 = if
+        lits> dup 1 = if  2drop exit  then
+        dup 1 > if
+            lit/s, drop exit then
+        >lits then
+    fold2-1 ;
+' opt-/s optimizes /s
+
+: opt-mods ( xt -- )
+    lits# 1 = if
+        lits> dup 1 > if
+            ]] dup [[ dup lit/s, ]] literal * - [[ drop exit then
+        >lits then
+    fold2-1 ;
+' opt-mods optimizes mods
+
+: opt-/mods ( xt -- )
+    lits# 1 = if
+        lits> dup 1 > if
+            ]] dup [[ dup lit/s, ]] tuck literal * - swap [[ drop exit then
+        >lits then
+    fold2-2 ;
+' opt-/mods optimizes /mods
@@ -78,6 +78,7 @@ require simp-see.fs
 require debug.fs
 require libcc.fs
 require str-exec.fs
+require perfmap.fs
 require dis-gdb.fs
 require gforthrc.fs
 require ansi.fs
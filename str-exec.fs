@@ -1,7 +1,7 @@
 \ >STRING-EXECUTE >BUFFER-EXECUTE
 \
 \ Authors: Anton Ertl, Bernd Paysan
-\ Copyright (C) 2011,2016,2019,2023 Free Software Foundation, Inc.
+\ Copyright (C) 2011,2016,2019,2023,2026 Free Software Foundation, Inc.
 
 \ This file is part of Gforth.
 
@@ -18,21 +18,49 @@
 \ You should have received a copy of the GNU General Public License
 \ along with this program. If not, see http://www.gnu.org/licenses/.
 
+\ All captures of a task append to one buffer, which is kept for the
+\ next capture: a nested capture just continues behind the output of
+\ the enclosing one, and when it ends, its output is cut off again.
+\ Only the result of >STRING-EXECUTE is allocated; >SLICE-EXECUTE
+\ returns the output in the buffer.  The buffer outlives arenas, so
+\ it is managed with heap-resize and heap-free, not with the current
+\ memory words.
+
 32 constant >string-initial-buflen
 
-2variable >string-buffer \ buffer
-variable  >string-len    \ actual string length
+$10000 Value >string-keep ( -- u ) \ gforth-experimental
+\G At the start of an outermost @code{>string-execute} or
+\G @code{>slice-execute}, the capture buffer is freed if it is larger
+\G than @i{u} bytes; smaller buffers are reused.
+
+User >string-buffer cell uallot drop \ buffer address, then its size
+User >string-len    \ actual string length
+User >string-up     \ the task that owns >string-buffer
+
+: >string-start ( -- )
+    \ the user area of a new task is a copy, so it does not own the buffer
+    >string-up @ up@ <> IF
+	0 0 >string-buffer 2!  0 >string-len !  up@ >string-up !  EXIT  THEN
+    >string-len @ 0= >string-buffer cell+ @ >string-keep u> and IF
+	>string-buffer @ heap-free throw  0 0 >string-buffer 2!  THEN ;
+
+: >string-room ( u -- )
+    \ make >string-buffer at least u bytes long
+    >string-buffer 2@ swap { buf-addr buf-size }
+    buf-size >string-initial-buflen max
+    begin  2dup u<  while  2*  repeat  nip { new-size }
+    buf-addr new-size heap-resize throw new-size swap >string-buffer 2! ;
 
 : >string-type { c-addr u -- }
-    >string-len @ { str-len }
-    str-len u + { new-str-len }
-    >string-buffer 2@
-    begin { buf-addr buf-size }
-	new-str-len buf-size > while
-	    buf-size 2* buf-addr over resize throw swap
-	    2dup >string-buffer 2!
-    repeat 
-    c-addr buf-addr str-len + u move
+    >string-len @ u + { new-str-len }
+    >string-buffer 2@ swap { buf-addr buf-size }
+    new-str-len buf-size u> if
+	new-str-len >string-room
+	c-addr buf-addr - buf-size u< if \ a slice of the buffer
+	    c-addr buf-addr - >string-buffer @ + to c-addr  then
+    then
+    >string-buffer @ >string-len @ + { dest }
+    c-addr dest <> if  c-addr dest u move  then
     new-str-len >string-len ! ;
 
 : >string-emit { c^ c -- }
@@ -43,27 +71,43 @@ variable  >string-len    \ actual string length
 
 ' >string-type ' >string-emit ' >string-cr ' >string-form output: >string-out
 
-: >string-execute ( ... xt -- ... addr u ) \ gforth
-    \G execute xt while the standard output (@code{type}, @code{emit},
-    \G and everything that uses them) is redirected to a string.  The
-    \G resulting string is addr u, which is in @code{allocate}d
-    \G memory; it is the responsibility of the caller of
-    \G @code{>string-execute} to @code{free} this string.
-    >string-buffer 2@ >string-len @ op-vector @
-    { d: oldbuf oldlen oldvector }
+: >string-capture ( ... xt -- ... u-start u-end )
+    \ the output of xt is at u-start..u-end in >string-buffer, which
+    \ is cut off again (>string-len is u-start)
+    >string-start
+    >string-len @ op-vector @ { start oldvector }
     try
-	>string-initial-buflen dup allocate throw swap >string-buffer 2!
-	0 >string-len !
 	>string-out
 	execute
-	>string-buffer 2@ drop >string-len @ tuck resize throw swap
+	>string-len @
 	0 \ throw ball
     restore
-	oldbuf >string-buffer 2!
-	oldlen >string-len !
+	start >string-len !
 	oldvector op-vector !
     endtry
-    throw ;
+    throw start swap ;
+
+: >string-execute ( ... xt -- ... addr u ) \ gforth
+    \G execute xt while the standard output (@code{type}, @code{emit},
+    \G and everything that uses them) is redirected to a string.  The
+    \G resulting string is addr u, which is in @code{allocate}d
+    \G memory; it is the responsibility of the caller of
+    \G @code{>string-execute} to @code{free} this string.
+    >string-capture over - { start u }
+    u allocate throw >string-buffer @ start + over u move u ;
+
+: >slice-execute ( ... xt -- ... addr u ) \ gforth-experimental
+    \G Like @code{>string-execute}, but addr u is in the capture buffer
+    \G of the task and must not be freed.  It is valid until the next
+    \G output in an enclosing @code{>string-execute} or
+    \G @code{>slice-execute} (typing addr u there as first output does
+    \G not copy it), or until the next outermost one starts.
+    >string-capture over - swap >string-buffer @ + swap ;
+
+' >string-execute nonescaping
+' >slice-execute nonescaping
+
+:noname ( -- )  defers 'image  >string-up off ; is 'image
 
 \ altenative interface (for systems without memory allocation wordset):
 
@@ -83,7 +83,7 @@ UValue $? ( -- n ) \ gforth dollar-question
 \G value) is prepended to the string (mainly to support using
 \G @code{command.com} as shell in Windows instead of whatever shell
 \G Cygwin uses by default; @pxref{Environment variables}).
-    (system) throw TO $? ;
+    obuf-flush (system) throw TO $? ;
 
 : sh ( "..." -- ) \ gforth
 \G Execute the rest of the command line as shell command(s).
@@ -426,6 +426,58 @@ constant mem*do-noconstant
 \G notation for all numbers.
     f>str-rdp type ;
 
+: zeros-hold ( n -- )
+    0 max 0 ?DO  '0' hold  LOOP ;
+
+: f>str-shortest ( r -- c-addr u ) \ gforth
+\G Convert @i{r} into the shortest string that @code{>float}
+\G converts back to @i{r}.  Fixed-point notation is used if the
+\G decimal point is at most 21 digits right or 6 digits left of the
+\G first significant digit, otherwise exponential notation (like
+\G number-to-string conversion in JavaScript).  Non-finite values
+\G produce @code{NaN}, @code{infinity} or @code{-infinity}.  The
+\G result is in the pictured numeric output buffer and will be
+\G destroyed by anything destroying that buffer.
+    { | digits[ #20 ] }
+    digits[ #20 represent-shortest { k n fneg fok }
+    <<# fok 0= IF  digits[ k -trailing holds  #0. #> #>>  EXIT  THEN
+    n #21 <= IF
+	k n <= IF
+	    n k - zeros-hold  digits[ k holds
+	    #0.  fneg IF  '-' hold  THEN  #> #>>  EXIT  THEN
+	n 0> IF
+	    digits[ n + k n - holds  '.' hold  digits[ n holds
+	    #0.  fneg IF  '-' hold  THEN  #> #>>  EXIT  THEN
+	n -6 > IF
+	    digits[ k holds  n negate zeros-hold  s" 0." holds
+	    #0.  fneg IF  '-' hold  THEN  #> #>>  EXIT  THEN
+    THEN
+    base @ >r decimal
+    n 1- s>d tuck dabs #s rot sign 'e' hold 2drop
+    r> base !
+    k 1 > IF  digits[ 1+ k 1- holds  '.' hold  THEN  digits[ c@ hold
+    #0.  fneg IF  '-' hold  THEN  #> #>> ;
+
+: f.shortest ( r -- ) \ gforth
+\G Display @i{r} as the shortest string that @code{>float} converts
+\G back to @i{r} (@pxref{f>str-shortest}), followed by a space.
+    f>str-shortest type space ;
+
+User num>str-buf  9 cells cell- uallot drop
+
+: u>str ( u -- c-addr u1 ) \ gforth u-to-string
+\G Convert @i{u} into its digits in @code{base}.  The string is in a
+\G per-task buffer that is overwritten by the next @code{u>str} or
+\G @code{n>str}; unlike @code{<<# #s #>}, it does not use the
+\G pictured numeric output buffer.
+    base @ dup 2 u< -&24 and throw
+    num>str-buf [ 9 cells ] Literal + dup >r (u#s) r> over - ;
+
+: n>str ( n -- c-addr u ) \ gforth n-to-string
+\G Convert @i{n} into a string like @code{u>str}, with a leading
+\G @code{-} if @i{n} is negative.
+    dup abs u>str rot 0< IF  -1 /string  over '-' swap c!  THEN ;
+
 0 [if]
 : testx ( rf ur nd up -- )
     '| emit f.rdp ;
@@ -623,6 +675,7 @@ alias xd>s ( xd -- d ) \ gforth
 	default-out op-vector !
 	to outfile-id execute 0
     restore
+	obuf-flush \ the buffer must not outlive file-id
 	oldfid to outfile-id
 	oldout op-vector !
     endtry
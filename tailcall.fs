@@ -0,0 +1,57 @@
+\ tail-call elimination
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ When ;s is compiled (by EXIT or ;) right behind the call of a colon
+\ definition or deferred word, the call is turned into a jump: "call
+\ x" becomes "branch x", and "lit-perform a" becomes "lit a @
+\ execute-;s".  This happens before the native code is generated
+\ (by FLUSH-CODE at the end of the definition), so we can still patch
+\ the threaded code.  The ;s stays behind the jump, so branches to it
+\ still work.  If locals have to be freed, EXIT compiles lp+!# before
+\ the ;s, and the call is not a tail call; so the callee can still
+\ access locals of the caller, e.g., through w^ or addr locals.
+
+Variable tail-calls ( -- addr ) \ gforth-experimental
+\G If on (the default after loading @file{tailcall.fs}), calls of
+\G colon definitions and deferred words right before @code{exit} or
+\G @code{;} are compiled as jumps.  The callers of such words do not
+\G show up in backtraces.
+tail-calls on
+
+Variable tail-end \ HERE behind the last call of a colon or deferred word
+
+: tail-kind? ( xt -- f )
+    \ xt is compiled as a call of a colon definition or deferred word
+    >namehm @ >hmcompile, @ dup ['] :, = swap ['] defer, = or ;
+
+: tail-call, ( -- )
+    \ turn the call right before HERE into a jump
+    here 2 cells - dup @ ['] call = IF
+	['] branch swap !  EXIT  THEN
+    dup @ ['] lit-perform = IF
+	['] lit swap !
+	['] @ peephole-compile,  ['] execute-;s peephole-compile,  EXIT  THEN
+    drop ;
+
+:noname ( xt -- )
+    dup ['] ;s =  tail-end @ here = and  lits# 0= and  tail-calls @ and
+    IF  tail-call,  THEN
+    dup tail-kind? >r  defers compile,
+    r> IF  here  ELSE  0  THEN  tail-end ! ; is compile,
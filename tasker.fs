@@ -40,7 +40,7 @@ Create sleepers  sleepers A, sleepers A, 0 ,
 
 : stop ( -- )
     \G STOP sleeps a task and switches to the next
-    rp@ fp@ lp@ sp@ save-task !
+    obuf-flush  rp@ fp@ lp@ sp@ save-task !
     next-task @ up! save-task @ sp!
     lp! fp! rp! prev-task @ sleep ;
 
@@ -63,6 +63,7 @@ User task-dp
     dup r@ user' task-dp + dup >r !
     r> r@ user' dp  + ! 2drop
     0 r@ user' current-input + !
+    0 r@ user' obuf + !  0 r@ user' obuf# + !
     r> dup 2dup 2! dup sleep ;
 
 Create killer killer A, killer A,
@@ -73,7 +74,7 @@ Create killer killer A, killer A,
 
 :noname ( -- )
     \G kills the current task, also on bottom of return stack of a new task
-    next-task @ up! save-task @ sp!
+    0 set-obuf  next-task @ up! save-task @ sp!
     lp! fp! rp! prev-task @ kill ; IS kill-task
 
 : (pass) ( x1 .. xn n task -- )
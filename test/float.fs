@@ -51,6 +51,17 @@ decimal
 { s"   " >float 0e f= -> true true }
 { s" 2e+3e" >float -> false }
 { s" 2+3" >float -> 2000e true }
+{ s" .5" >float -> 0.5e true }
+{ s" 1d5" >float -> 100000e true }
+{ s" 1..2" >float -> false }
+{ s" 1e" >float -> 1e true }
+{ s" -0" >float 0e f= -> true true }
+{ s" 9007199254740993" >float -> 9007199254740992e true }
+{ s" 9007199254740995" >float -> 9007199254740996e true }
+{ s" 0.1" >float -> 1e 10e f/ true }
+{ s" 123456789012345678901234567890" >float -> 1.2345678901234568e29 true }
+{ s" 2.2250738585072014e-308" >float -> 2.2250738585072014e-308 true }
+{ s" 1,5" ',' >float1 -> 1.5e true }
 
 set-near
 \ transcendenal and other functions, mainly test effect on TOS (not FTOS)
@@ -0,0 +1,113 @@
+\ test Gforth extensions that change the compiler and the allocator
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ These are not in gforth.fs, because loading them would change the
+\ configuration that the later tests there see.
+
+require ./tester.fs
+decimal
+
+\ automatic inlining
+
+require inline.fs
+
+: t-inlined? ( xt -- flag )  >namehm @ >hmcompile, @ ['] inline-compile, = ;
+
+: t-in1 ( n -- n+1 )  1 + ;
+: t-in2 ( -- n )  4 t-in1 t-in1 ;
+t{ ' t-in1 t-inlined? -> true }t
+t{ 5 t-in1 -> 6 }t
+t{ t-in2 -> 6 }t
+threading-method 1 <> [IF]
+    \ the literals of the caller are folded with the inlined code
+    \ (no code is generated before the ;)
+    Variable t-in-size
+    : t-in3 ( -- n )  [ here ] 3 t-in1 [ here swap - t-in-size ! ] ;
+    t{ t-in-size @ -> 0 }t
+    t{ t-in3 -> 4 }t
+[THEN]
+
+: t-nin1 ( n -- n' )  {: a :} a 1+ ;
+: t-nin2 ( n -- n' )  0< IF  1  ELSE  2  THEN ;
+: t-nin3 ( -- x )  r@ ;
+: t-nin4 ( -- x x )  t-nin3 r@ ;
+t{ ' t-nin1 t-inlined? -> false }t
+t{ ' t-nin2 t-inlined? -> false }t
+t{ ' t-nin3 t-inlined? -> false }t
+t{ 5 t-nin1 -1 t-nin2 0 t-nin2 -> 6 1 2 }t
+t{ t-nin4 <> -> true }t
+
+\ tail calls; in gforth-itc compile, does not go through the optimizer
+
+require tailcall.fs
+
+0 to inline-auto \ the callees must remain calls
+
+threading-method 1 <> [IF]
+    : t-tc1 ( n -- addr )  dup 0= IF  drop rp@ EXIT  THEN  1- recurse ;
+    t{ 0 t-tc1 100000 t-tc1 = -> true }t
+
+    Defer t-odd?
+    : t-even? ( n -- f )  dup 0= IF  drop true EXIT  THEN  1- t-odd? ;
+    :noname ( n -- f )  dup 0= IF  drop false EXIT  THEN  1- t-even? ; is t-odd?
+    t{ 100000 t-even? 100001 t-even? -> true false }t
+
+    : t-tc2 ( n -- n' )  #10 + ;
+    : t-tc3 ( n -- n' )  dup 0> IF  1- t-tc2  THEN ; \ ;s is a branch target
+    t{ 5 t-tc3 -5 t-tc3 -> #14 -5 }t
+
+    : t-rp ( -- addr )  rp@ ;
+    : t-tc4 ( -- addr )  t-rp ;
+    : t-tc5 ( -- addr )  0 {: a :} t-rp ; \ not a tail call, frees locals
+    t{ t-tc4 t-tc5 - -> cell }t
+    t{ 5 [: {: a :} a t-tc2 ;] execute -> #15 }t
+[THEN]
+
+\ size-class pools and arenas
+
+#100 allocate throw Value t-pre-pool \ allocated with malloc
+
+require pool.fs
+
+: t-pool1 ( u -- flag )
+    \ allocate, use, resize and free a block of u bytes
+    dup allocate throw {: u a :}
+    a allocation-size dup u u>= swap 0= or \ 0: size unknown
+    a u 'x' fill  a u 2* resize throw to a
+    a u + 1- c@ 'x' = and  a free throw ;
+t{ 1 t-pool1 2 cells t-pool1 #17 t-pool1 -> true true true }t
+t{ #64 cells t-pool1 #64 cells 1+ t-pool1 #10000 t-pool1 -> true true true }t
+
+: t-pool2 ( -- flag )
+    \ resize a small block to a large one
+    #10 allocate throw {: a :}  s" abcdefghij" a swap move
+    a #10000 resize throw to a
+    a #10 s" abcdefghij" str=  a free throw ;
+t{ t-pool2 -> true }t
+t{ t-pre-pool free -> 0 }t
+
+: t-arena1 ( -- c )
+    arena{  #100 allocate throw {: a :}
+    arena{  a free throw  #50 allocate throw drop  }arena
+    a #100 'y' fill  a #99 + c@  }arena ;
+t{ t-arena1 current-memory-words heap-words = -> 'y' true }t
+: t-arena2 ( -- )  #100 allocate throw drop  5 throw ;
+t{ ['] t-arena2 ['] arena-execute catch nip current-memory-words heap-words =
+   -> 5 true }t
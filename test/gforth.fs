@@ -37,6 +37,43 @@ t{    999.9994e 7 3 1 f>str-rdp s" 999.999" str= -> true }t
 t{    999.9996e 7 3 1 f>str-rdp s" 1.000E3" str= -> true }t
 t{       -1e-20 5 2 1 f>str-rdp s" *****"   str= -> true }t
 
+\ f>str-shortest and the shortest path of represent
+
+t{    0.1e f>str-shortest s" 0.1"       str= -> true }t
+t{   -1.5e f>str-shortest s" -1.5"      str= -> true }t
+t{  100e   f>str-shortest s" 100"       str= -> true }t
+t{    0e   f>str-shortest s" 0"         str= -> true }t
+t{   1e21  f>str-shortest s" 1e21"      str= -> true }t
+t{   1e-7  f>str-shortest s" 1e-7"      str= -> true }t
+t{ 1.25e-6 f>str-shortest s" 0.00000125" str= -> true }t
+t{ 0.1e 0.2e f+ f>str-shortest s" 0.30000000000000004" str= -> true }t
+t{ 1e 0e f/ f>str-shortest s" infinity" str= -> true }t
+t{ 0.3e pad 15 represent 2drop drop pad 15 s" 300000000000000" str= -> true }t
+t{ 0.1e 0.2e f+ pad 17 represent 2drop drop pad 17 s" 30000000000000004" str= -> true }t
+
+: shortest-round-trip ( u -- f )
+    \ round-trip u pseudo-random doubles through f>str-shortest
+    $2545F491 swap 0 ?DO
+	dup $FFFFFF and s>f  dup #8 rshift $FFFF and 1 or s>f f/
+	dup $3F and #32 - s>f 10e fswap f** f*
+	fdup f>str-shortest >float 0= IF  fdrop drop false  UNLOOP EXIT  THEN
+	f<> IF  drop false  UNLOOP EXIT  THEN
+	dup #13 lshift xor dup #17 rshift xor dup #5 lshift xor
+    LOOP  drop true ;
+t{ #10000 shortest-round-trip -> true }t
+
+\ #s, u>str, n>str
+
+t{ 0 u>str s" 0" str= -> true }t
+t{ 1234567890 u>str s" 1234567890" str= -> true }t
+t{ -1 n>str s" -1" str= -> true }t
+t{ 1 cell 8 * 1- lshift dup n>str rot s>d tuck dabs <<# #s rot sign #> str= #>> -> true }t
+t{ -1 dup u>str rot 0 <<# #s #> str= #>> -> true }t
+t{ $DEADBEEF ' u>str $10 base-execute s" DEADBEEF" str= -> true }t
+t{ #100 ' u>str 7 base-execute s" 202" str= -> true }t
+t{ #123 0 <<# #s 2drop 'x' hold #12 0 #s #> s" 12x123" str= #>> -> true }t
+t{ 1 1 <<# ' #s $10 base-execute #> nip #>> -> cell 2* 1+ }t
+
 \ 0x hex number conversion, or not
 
 decimal
@@ -448,6 +485,20 @@ t{ :noname -20 -3 /f    ; execute ->  6 }t
 t{ :noname -20 -3 modf  ; execute ->  -2 }t
 t{ :noname -20 -3 /modf ; execute ->  -2 6 }t
 
+\ symmetric division by a literal
+t{ -21 :noname 4 /s    ; execute -> -5 }t
+t{ -21 :noname 4 mods  ; execute -> -1 }t
+t{ -21 :noname 4 /mods ; execute -> -1 -5 }t
+t{ -20 :noname 3 /s    ; execute -> -6 }t
+t{  20 :noname 3 mods  ; execute ->  2 }t
+t{ -20 :noname 3 /mods ; execute -> -2 -6 }t
+t{ max-n 1+ :noname 3 /s ; execute -> max-n 1+ 3 /s }t
+
+\ identities with one literal
+t{ 5 :noname 1 *  -1 xor 0 or -1 and 0 lshift ; execute -> -6 }t
+t{ 5 :noname -1 *  0 and ; execute -> 0 }t
+t{ 5 :noname -1 or ; execute -> -1 }t
+
 \ closures
 
 \ : homeloc <{: w^ a w^ b w^ c :}h a b c ;> ;
@@ -460,6 +511,14 @@ t{ 1 2 ' + combiner dup execute swap >addr free -> 3 0 }t
 t{ #1234 #5678 ' xor combiner dup execute swap >addr free -> #4860 0 }t
 t{ 0 0 ' + combiner #1234 #5678 third >body 2! dup execute swap >addr free -> #6912 0 }t
 
+\ one-shot closures, and closures that do not escape (on the locals stack)
+: add1 [{: a b :}h1 a b + ;] ;
+t{ 1 2 add1 3 4 add1 execute swap execute -> 7 3 }t
+: add2 {: x :} [{: a b :}h1 a b + x + ;] execute x ;
+t{ 1 2 3 add2 -> 6 3 }t
+: add3 [{: a :}d a 2* ;] catch ;
+t{ 5 add3 -> #10 0 }t
+
 : A {: w^ k x1 x2 x3 xt: x4 xt: x5 | w^ B :} recursive
     k @ 0<= IF  x4 x5 +  ELSE
 	B k x1 x2 x3 action-of x4 [{: B k x1 x2 x3 x4 :}L
@@ -551,6 +610,23 @@ t{ max-n 1+ max-n u-[do-test -> }t
     rdrop rdrop rdrop rdrop ;
 t{ 1 2 3 4 t-rpick -> 4 3 2 1 }t
 
+\ catch and throw restore the return stack (also the cached top of
+\ the return stack with rtos_opt=1)
+
+: t-throw ( n -- )  throw ;
+: t-catch-r ( n1 n2 -- n3 )  >r ['] t-throw catch r> + ;
+t{ 3 5 t-catch-r -> 8 }t
+t{ 0 5 t-catch-r -> 5 }t
+: t-catch-r2 ( -- n )  7 >r [: 1 >r 2 >r 3 throw ;] catch r> + ;
+t{ t-catch-r2 -> #10 }t
+
+\ nested >string-execute and >slice-execute
+
+: t-str-exec ( -- )  ." a" [: ." bc" ;] >slice-execute type ." d" ;
+t{ ' t-str-exec >string-execute over >r s" abcd" compare r> free throw -> 0 }t
+t{ [: ." x" ['] t-str-exec >string-execute 2dup type drop free throw ;]
+   >slice-execute s" xabcd" compare -> 0 }t
+
 \ refill with&without newline at end of last line
 \ (do not add a newline to the end of this buffer!)
 \ This test absolutely has to be the last one in this file, don't add
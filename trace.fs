@@ -0,0 +1,143 @@
+\ event tracing into per-task ring buffers
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ Unlike ~~, tracing does not print anything while the program runs:
+\ every event is stored with a timestamp in a ring buffer of the
+\ current task, which only this task writes to, so no locking is
+\ needed.  Tasks without a ring buffer just skip the events.  The
+\ buffers can be written as a Chrome trace JSON file, which can be
+\ viewed with Perfetto (https://ui.perfetto.dev) or chrome://tracing.
+
+\ A ring: owning task, number of entries (a power of 2), number of
+\ events written, link, task number; then the entries: ntime, kind
+\ ('B'egin, 'E'nd, 'i'nstant), name (c-addr u)
+
+5 cells Constant /trace-ring
+5 cells Constant /trace-entry
+
+$4000 Value trace-entries ( -- u ) \ gforth-experimental
+\G The number of events (a power of 2) the ring buffer of a task
+\G started with @code{trace-start} holds; older events are
+\G overwritten.
+
+User trace-ring  trace-ring off
+Variable trace-rings  \ list of all rings
+Variable #trace-rings
+2Variable trace-epoch \ time of the first trace-start
+Variable trace-new-tasks ( -- addr ) \ gforth-experimental
+\G If on, tasks created (by @file{unix/pthread.fs}) start tracing.
+
+: trace-start ( -- ) \ gforth-experimental
+    \G Trace the events of the current task from now on.
+    trace-ring @ ?dup-IF  @ up@ = ?EXIT  THEN
+    trace-epoch 2@ d0= IF  ntime trace-epoch 2!  THEN
+    trace-entries /trace-entry * /trace-ring + allocate throw {: r :}
+    up@ r !  trace-entries r cell+ !  0 r 2 cells + !
+    1 #trace-rings +!@ r 4 cells + !
+    BEGIN  trace-rings @ dup r 3 cells + !
+	dup r swap trace-rings ?!@ =  UNTIL
+    r trace-ring ! ;
+
+: trace-stop ( -- ) \ gforth-experimental
+    \G Stop tracing the current task; its events so far are kept.
+    trace-ring off ;
+
+: trace-event ( c-addr u kind -- )
+    trace-ring @ {: r :}
+    r 0= IF  drop 2drop  EXIT  THEN
+    r @ up@ <> IF  drop 2drop  EXIT  THEN \ the creator's ring
+    r 2 cells + @ {: n :}
+    r /trace-ring + n r cell+ @ 1- and /trace-entry * + {: e :}
+    e 2 cells + !  e 3 cells + 2!  ntime e 2!
+    n 1+ r 2 cells + ! ;
+
+: trace-begin ( c-addr u -- ) \ gforth-experimental
+    \G Record the beginning of a span named @i{c-addr u} (the string
+    \G must still be there when the trace is written).
+    'B' trace-event ;
+
+: trace-end ( -- ) \ gforth-experimental
+    \G Record the end of the innermost span begun in this task.
+    0 0 'E' trace-event ;
+
+: trace-instant ( c-addr u -- ) \ gforth-experimental
+    \G Record an event named @i{c-addr u} without duration.
+    'i' trace-event ;
+
+: trace{ ( compilation "name" -- ; run-time -- ) \ gforth-experimental trace-brace
+    \G Begin a span named @i{name}; end it with @code{@}trace}.
+    parse-name postpone SLiteral postpone trace-begin ; immediate compile-only
+
+' trace-end alias }trace ( -- ) \ gforth-experimental brace-trace
+\G End the innermost span begun in this task.
+
+: trace-reset ( -- ) \ gforth-experimental
+    \G Forget the events recorded so far in all tasks.
+    trace-rings @ BEGIN  dup  WHILE
+	    0 over 2 cells + !  3 cells + @  REPEAT  drop ;
+
+\ Chrome trace event format
+
+0 Value trace-first?
+
+: .json-string ( c-addr u -- )
+    \ print c-addr u as JSON string (also used by bench.fs)
+    '"' emit  bounds ?DO
+	I c@ dup '"' = over [char] \ = or IF  [char] \ emit  THEN  emit
+    LOOP  '"' emit ;
+
+: .trace-sep ( -- )
+    trace-first? IF  false to trace-first?  ELSE  ',' emit cr  THEN ;
+
+: .trace-entry ( utask entry -- )
+    {: e :}  .trace-sep  '{' emit
+    e 2 cells + @ 'E' <> IF
+	.\" \"name\":" e 3 cells + 2@ .json-string ',' emit  THEN
+    .\" \"ph\":\"" e 2 cells + @ emit
+    .\" \",\"ts\":" e 2@ trace-epoch 2@ d- <<# # # # '.' hold #s #> type #>>
+    e 2 cells + @ 'i' = IF  .\" ,\"s\":\"t\""  THEN
+    .\" ,\"pid\":1,\"tid\":" 0 .r '}' emit ;
+
+: .trace-ring ( ring -- )
+    {: r :}  .trace-sep
+    .\" {\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+    r 4 cells + @ dup 0 .r .\" ,\"args\":{\"name\":\"task " 0 .r .\" \"}}"
+    r 2 cells + @ dup r cell+ @ - 0 max ?DO
+	r 4 cells + @  r /trace-ring + I r cell+ @ 1- and /trace-entry * +
+	.trace-entry
+    LOOP ;
+
+: .trace-json ( -- )
+    true to trace-first?
+    .\" {\"traceEvents\":[" cr
+    trace-rings @ BEGIN  dup  WHILE
+	    dup .trace-ring  3 cells + @  REPEAT  drop
+    cr .\" ],\"displayTimeUnit\":\"ns\"}" cr ;
+
+: trace-json ( c-addr u -- ) \ gforth-experimental
+    \G Write the events recorded so far in all tasks to the file
+    \G @i{c-addr u} in the Chrome trace event format.
+    w/o create-file throw >r
+    ['] .trace-json r@ outfile-execute
+    r> close-file throw ;
+
+:noname defers 'image
+    trace-ring off  trace-rings off  #trace-rings off
+    0. trace-epoch 2! ; is 'image
@@ -0,0 +1,129 @@
+\ tuning the code generation options of the engine for a workload
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ The options are applied when the engine generates code, so every
+\ configuration is measured in a new engine process that runs the
+\ workload with bench.fs; the results are collected in the JSON file
+\ tune-results.  Trying all combinations of the knobs would take far
+\ too long, so the knobs are tuned one after the other (coordinate
+\ descent): each value of a knob is measured with the best values
+\ found so far for the other knobs, and kept if it is faster.
+
+\ Usage: gforth tune.fs -e "s\" gforth-fast\" s\" work.fs\" tune bye"
+\ where work.fs defines main, like the benchmarks of bench.fs.
+
+require bench.fs
+
+$Variable tune-engine   \ the engine command
+$Variable tune-workload \ the file defining main
+$Variable tune-label    \ engine label of the current measurement
+$Variable tune-results  s" tune.json" tune-results $!
+$Variable tuned-options ( -- $addr ) \ gforth-experimental
+\G The options found by the last @code{tune}.
+Variable #tune-runs
+Variable tune-best      \ best median so far
+
+\ a knob is a $[] of option strings, "-" for the default
+
+Variable knobs \ $-string: cell array of knobs
+#16 Constant max-knobs
+Create choices max-knobs cells allot \ index of the value of each knob
+
+: knob ( "option1" ... "optionn" -- )
+    \ a knob with the rest of the line as values, the first is the default
+    here 0 , {: k :}
+    BEGIN  parse-name dup  WHILE  k $+[]!  REPEAT  2drop
+    k {: w^ x :} x cell knobs $+! ;
+
+knob - --ss-number=0 --ss-number=50 --ss-number=200
+knob - --ss-states=1 --ss-states=2 --ss-states=4
+knob - --ss-min-ls --ss-min-lsu --ss-min-nexts
+knob - --ss-greedy
+knob - --opt-ip-updates=0 --opt-ip-updates=1
+knob - --code-block-size=64k --code-block-size=2M
+knob - --tpa-noequiv
+
+: #knobs ( -- u )  knobs $@ nip cell/ ;
+: knob@ ( u -- $[]addr )  cells knobs $@ drop + @ ;
+
+: .choices ( -- )
+    \ the options of the current choices, each preceded by a space
+    #knobs 0 ?DO
+	choices I cells + @ I knob@ $[]@
+	2dup s" -" str= IF  2drop  ELSE  space type  THEN
+    LOOP ;
+
+: .tune-command ( c-addr u -- )
+    \ the shell command for measuring with the options c-addr u
+    ." GFORTH_BENCH_JSON=" tune-results $. space
+    tune-engine $. type  .\"  bench.fs -e 's\" " tune-label $.
+    .\" \" s\" " tune-workload $. .\" \" bench-file bench-bye'" ;
+
+: tune-median ( -- u )
+    \ the median of the last measurement in tune-results
+    bench-baseline $[]free  tune-results $@ bench-baseline $[]slurp-file
+    tune-label $@ bench-engine $!
+    tune-workload $@ baseline-median 0= abort" tune: no result" ;
+
+: tune-run ( c-addr u -- u )
+    \ the median time of the workload with the options c-addr u
+    1 #tune-runs +!  [: ." tune-" #tune-runs @ 0 .r ;] $tmp tune-label $!
+    2dup type ." :" cr
+    ['] .tune-command $tmp system
+    $? abort" tune: the workload failed"  tune-median ;
+
+: try-choice ( u-value u-knob -- )
+    \ measure with value u-value of knob u-knob, and keep it if faster
+    cells choices + dup @ {: addr old :}  addr !
+    ['] .choices $tmp tune-run dup tune-best @ u< IF
+	tune-best !  ELSE  drop old addr !  THEN ;
+
+: tune ( c-addr1 u1 c-addr2 u2 -- ) \ gforth-experimental
+    \G Find the code generation options with which the engine started
+    \G by the command @i{c-addr1 u1} (e.g., @code{gforth-fast}) runs
+    \G the workload in the file @i{c-addr2 u2} fastest.  The file
+    \G defines @code{main}, like the benchmarks of @file{bench.fs},
+    \G and is measured with @file{bench.fs} in a new process for every
+    \G configuration tried.  Show the options found and store them in
+    \G @code{tuned-options} and @code{image-options}.
+    tune-workload $!  tune-engine $!
+    tune-results $@ delete-file drop  #tune-runs off
+    choices max-knobs cells erase
+    0 0 tune-run tune-best !
+    #knobs 0 ?DO
+	I knob@ $[]# 1 ?DO  I J try-choice  LOOP
+    LOOP
+    ['] .choices $tmp 1 /string 0 max tuned-options $!
+    tuned-options $@ image-options $!
+    ." recommended:" tuned-options $@ dup IF  space type
+    ELSE  2drop ."  the defaults"  THEN  cr ;
+
+: .tune-image ( c-addr u -- )
+    tune-engine $. .\"  -e 's\" " tuned-options $.
+    .\" \" image-options $! savesystem " type ."  bye'" ;
+
+: tune-image ( c-addr u -- ) \ gforth-experimental
+    \G Save an image file @i{c-addr u} (with the engine of the last
+    \G @code{tune}) that is the engine's default image with
+    \G @code{tuned-options} as defaults; to store them in an image of
+    \G your own, use @code{savesystem} after @code{tune}, or set
+    \G @code{image-options}.
+    ['] .tune-image $tmp system
+    $? abort" tune-image: savesystem failed" ;
@@ -0,0 +1,124 @@
+\ mmap-based blocks
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ In mmap mode, BLOCK returns an address inside a shared mapping of
+\ the blocks file, so there is no copying and no buffer replacement.
+\ UPDATE records the range of modified blocks, and SAVE-BUFFERS
+\ msyncs that range.  The mapping reserves address space beyond the
+\ end of the file; the file is extended (with blanks) when a block
+\ beyond its end is accessed.
+
+\ Changes in a shared mapping cannot be discarded, so EMPTY-BUFFERS
+\ only drops the mapping; modified blocks still reach the file.
+
+require ./mmap.fs
+
+0 Value block-map      \ start of the mapping of the blocks file
+0 Value block-map-size \ length of the mapping
+0 Value block-map-fid  \ the mapped blocks file
+0 Value block-map-file-size \ the size of the mapped blocks file
+Variable block-map-last \ offset of the current block in the mapping
+2Variable block-map-dirty \ offsets of the first and after the last updated block
+
+$4000000 Value block-map-reserve ( -- u ) \ gforth
+\G Minimal length of the address range reserved for the mapping of
+\G the blocks file.
+
+: block-map-clean ( -- )
+    -1 0 block-map-dirty 2!  block-map-last on ;
+
+: mmap-save-buffers ( -- ) \ gforth-internal
+    block-map-dirty 2@ { lo hi }  lo hi u< IF
+	lo pagesize negate and { start }
+	block-map start +  hi start -  MS_SYNC msync ?ior
+    THEN
+    -1 0 block-map-dirty 2! ;
+
+: block-unmap ( -- ) \ gforth-internal
+    block-map IF  block-map block-map-size munmap ?ior  THEN
+    0 to block-map  0 to block-map-size  0 to block-map-fid
+    block-map-clean ;
+
+: block-mmap ( u -- ) \ gforth-internal
+    \ map at least @i{u} bytes of the current blocks file
+    mmap-save-buffers block-unmap  get-block-fid { fid }
+    fid flush-file throw
+    fid file-size throw d>s dup to block-map-file-size
+    max block-map-reserve max >pagealign
+    0 over PROT_RW MAP_SHARED fid fileno 0 mmap dup ?ior
+    to block-map  to block-map-size  fid to block-map-fid ;
+
+: block-map-extend ( u -- ) \ gforth-internal
+    \ make sure that the blocks file is at least @i{u} bytes long
+    block-map-file-size { old } dup old u<= IF  drop  EXIT  THEN
+    dup 0 block-map-fid resize-file throw
+    dup to block-map-file-size
+    block-map old + swap old - blank ;
+
+: mmap-block ( u -- a-addr ) \ gforth-internal
+    dup offset @ u< -35 and throw
+    dup block-limit u>= -35 and throw
+    offset @ - chars/block chars * { pos }
+    pos chars/block chars + { end }
+    get-block-fid block-map-fid <> IF  end block-mmap  THEN
+    end block-map-size u> IF  end 2* block-mmap  THEN
+    end block-map-extend
+    pos block-map-last !  block-map pos + ;
+
+: mmap-update ( -- ) \ gforth-internal
+    block-map-last @ dup 0< IF  drop  EXIT  THEN
+    block-map-dirty 2@ { lo hi }
+    dup lo umin  swap chars/block chars + hi umax  block-map-dirty 2! ;
+
+: mmap-updated? ( n -- f ) \ gforth-internal
+    \ blocks between two updated blocks count as updated
+    offset @ - chars/block chars *
+    block-map-dirty 2@ within ;
+
+: mmap-blocks ( -- ) \ gforth
+    \G Switch @code{block} and friends to access the blocks file
+    \G through a shared mapping.  @code{block} then returns an
+    \G address inside the mapping, @code{save-buffers} and
+    \G @code{flush} @code{msync} the @code{update}d range, and
+    \G @code{empty-buffers} cannot discard changes.
+    flush
+    ['] mmap-block is block
+    ['] mmap-update is update
+    ['] mmap-save-buffers is save-buffers
+    ['] block-unmap is empty-buffers
+    ['] mmap-updated? is updated? ;
+
+: buffered-blocks ( -- ) \ gforth
+    \G Switch @code{block} and friends back to block buffers (the
+    \G default).
+    flush
+    ['] (block) is block
+    ['] (update) is update
+    ['] (save-buffers) is save-buffers
+    ['] (empty-buffers) is empty-buffers
+    ['] (updated?) is updated? ;
+
+:noname ( -- )
+    defers 'cold
+    0 to block-map  0 to block-map-size  0 to block-map-fid
+    block-map-clean
+; is 'cold
+
+block-map-clean
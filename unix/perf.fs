@@ -0,0 +1,168 @@
+\ hardware performance counters (Linux perf_event)
+
+\ Authors: Anton Ertl, Bernd Paysan
+\ Copyright (C) 2026 Free Software Foundation, Inc.
+
+\ This file is part of Gforth.
+
+\ Gforth is free software; you can redistribute it and/or
+\ modify it under the terms of the GNU General Public License
+\ as published by the Free Software Foundation, either version 3
+\ of the License, or (at your option) any later version.
+
+\ This program is distributed in the hope that it will be useful,
+\ but WITHOUT ANY WARRANTY; without even the implied warranty of
+\ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+\ GNU General Public License for more details.
+
+\ You should have received a copy of the GNU General Public License
+\ along with this program. If not, see http://www.gnu.org/licenses/.
+
+\ The counters are opened as one group for the current thread (in
+\ user mode only, so they work with the default perf_event_paranoid
+\ setting), and all read at once.  Counters that the CPU or the
+\ virtual machine does not support are left out of the group.
+
+c-library perf
+    \c #include <string.h>
+    \c #include <unistd.h>
+    \c #include <sys/ioctl.h>
+    \c #include <sys/syscall.h>
+    \c #include <linux/perf_event.h>
+    \c
+    \c static int gforth_perf_open(int type, long config, int group)
+    \c {
+    \c   struct perf_event_attr attr;
+    \c   memset(&attr, 0, sizeof(attr));
+    \c   attr.size = sizeof(attr);
+    \c   attr.type = type;
+    \c   attr.config = config;
+    \c   attr.disabled = (group == -1);
+    \c   attr.exclude_kernel = 1;
+    \c   attr.exclude_hv = 1;
+    \c   attr.read_format = PERF_FORMAT_GROUP;
+    \c   return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+    \c }
+    \c #define gforth_perf_enable(fd) \
+    \c   ioctl(fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP)
+    c-function perf-open gforth_perf_open n n n -- n ( type config group -- fd )
+    c-function perf-enable gforth_perf_enable n -- n ( fd -- r )
+    c-function perf-read read n a n -- n ( fd addr u -- u' )
+    c-function perf-close close n -- n ( fd -- r )
+end-c-library
+
+require ./libc.fs
+
+0 Constant PERF_TYPE_HARDWARE
+
+\ the counters: name and perf_event config
+Create counter-table
+0 , s" cycles"       string,  align
+1 , s" instructions" string,  align
+5 , s" branch-misses" string, align
+3 , s" cache-misses" string,  align
+
+4 Constant #counters ( -- u ) \ gforth-experimental
+\G Number of counters of @code{counters@{}.
+
+: counter-entry ( u -- addr )
+    counter-table swap 0 ?DO  cell+ count + aligned  LOOP ;
+
+: counter-name ( u -- c-addr u ) \ gforth-experimental
+    \G The name of counter @i{u}: 0 is @code{cycles}, 1
+    \G @code{instructions}, 2 @code{branch-misses}, 3
+    \G @code{cache-misses}.
+    counter-entry cell+ count ;
+
+User perf-up    \ the task that opened the counters
+User perf-fd    \ the group leader
+User perf-ids   \ bit u set: counter u is in the group
+User perf-fds  #counters cells cell- uallot drop \ fd of each counter, or -1
+User counter-start  #counters cells cell- uallot drop
+User counter-values #counters cells cell- uallot drop
+User perf-buf  #counters 1+ 8 * cell- uallot drop \ nr, values
+
+: perf-close-fds ( -- )
+    #counters 0 ?DO
+	perf-fds I cells + @ dup 0>= IF  perf-close  THEN  drop
+    LOOP ;
+
+: open-counters ( -- )
+    \ open the counters for the current thread
+    perf-ids off  -1 perf-fd !
+    #counters 0 ?DO
+	PERF_TYPE_HARDWARE I counter-entry @ perf-fd @ perf-open
+	dup perf-fds I cells + !  0>= IF
+	    perf-fd @ -1 = IF  perf-fds I cells + @ perf-fd !  THEN
+	    1 I lshift perf-ids or!
+	THEN
+    LOOP
+    perf-fd @ 0< -21 and throw \ unsupported operation
+    perf-fd @ perf-enable dup 0< IF  perf-close-fds  THEN  ?ior
+    up@ perf-up ! ;
+
+: close-counters ( -- ) \ gforth-experimental
+    \G Close the counters of the current thread; they are opened again
+    \G by the next @code{counters@{}.
+    perf-up @ up@ = IF  perf-close-fds  perf-up off  THEN ;
+
+: counters@ ( addr -- )
+    \ store the current counts to #counters cells at addr; counters
+    \ not in the group count 0
+    perf-fd @ perf-buf #counters 1+ 8 * perf-read ?ior
+    perf-buf 8 +  #counters 0 ?DO
+	1 I lshift perf-ids @ and IF
+	    dup x@ third I cells + !  8 +
+	ELSE  0 third I cells + !  THEN
+    LOOP  2drop ;
+
+: ?perf-open ( -- )
+    \ open the counters if necessary; they then count from now
+    perf-up @ up@ <> IF  open-counters  counter-start counters@  THEN ;
+
+: counters{ ( -- ) \ gforth-experimental counters-brace
+    \G Start counting cycles, instructions, branch misses and cache
+    \G misses of the current thread (in user mode).
+    ?perf-open  counter-start counters@ ;
+
+: }counters ( -- ) \ gforth-experimental brace-counters
+    \G The counts since the last @code{counters@{} are now available
+    \G with @code{counter@}.
+    ?perf-open  counter-values counters@
+    #counters 0 ?DO
+	counter-start I cells + @ negate counter-values I cells + +!
+    LOOP ;
+
+: counter@ ( u1 -- u2 ) \ gforth-experimental counter-fetch
+    \G @i{u2} is the count of counter @i{u1} between the last
+    \G @code{counters@{} and @code{@}counters}.
+    cells counter-values + @ ;
+
+: counters-execute ( ... xt -- ... ) \ gforth-experimental
+    \G Execute @i{xt}, counting; the counts are then available with
+    \G @code{counter@}.
+    counters{ catch }counters throw ;
+
+: .counters ( -- ) \ gforth-experimental dot-counters
+    \G Show the counts between the last @code{counters@{} and
+    \G @code{@}counters}, and the instructions per cycle.
+    #counters 0 ?DO
+	I counter@ 0 .r space I counter-name type space
+    LOOP
+    1 counter@ #100 0 counter@ 1 max */
+    0 <<# # # '.' hold #s #> type #>> ."  IPC" ;
+
+\ ~~ with counters instead of the stack
+
+: .~~counters ( -- )
+    ?perf-open  }counters .counters counters{ ;
+
+: counters-debugline ( view -- )
+    ?perf-open  action-of printdebugdata >r  ['] .~~counters is printdebugdata
+    ['] .debugline-directed catch  r> is printdebugdata  throw ;
+
+: ~~counters ( -- ) \ gforth-experimental tilde-tilde-counters
+    \G Like @code{~~}, but prints the hardware counts since the last
+    \G @code{~~counters} (or @code{counters@{}) of the current thread
+    \G instead of the stack.
+    compile-sourcepos POSTPONE counters-debugline ; immediate compile-only
@@ -155,6 +155,7 @@ opt: @ ]] literal * [[ ;
 
 require ./libc.fs
 require set-compsem.fs
+require trace.fs
 
 User pthread-id
 -1 cells pthread+ uallot drop
@@ -195,19 +196,79 @@ s" GFORTH_IGNLIB" getenv s" true" str= 0= [IF]
 :noname ( -- )
     epiper @ ?dup-if epiper off close-file drop  THEN
     epipew @ ?dup-if epipew off close-file drop  THEN
-    tmp$[] $[]free 0 (bye) ;
+    0 set-obuf  tmp$[] $[]free  closure-region-free 0 (bye) ;
 IS kill-task
 
 Defer thread-init
 :noname ( -- )
     rp@ cell+ backtrace-rp0 !  tmp$[] off  ofile off  tfile off
+    obuf off  obuf# off
     [IFDEF] sh$ #0. sh$ 2! [THEN]
-    current-input off create-input ; IS thread-init
+    current-input off create-input
+    trace-ring off  trace-new-tasks @ IF  trace-start  THEN ; IS thread-init
+
+\ stack usage
+
+: >stack-start ( addr1 -- addr2 )
+    \ the start of the next stack region after the one ending at addr1
+    pagesize 1- + pagesize negate and pagesize + ;
+
+: stacks-used ( task -- u-data u-return u-fp u-locals ) \ gforth-experimental
+    \G The high-water marks of the stacks of @i{task}: how many bytes
+    \G of each stack @i{task} has used so far.
+    {: t :}
+    t pagesize 2* +          sp0 t 's @ (stack-used)
+    sp0 t 's @ >stack-start  rp0 t 's @ (stack-used)
+    rp0 t 's @ >stack-start  fp0 t 's @ (stack-used)
+    fp0 t 's @ >stack-start  lp0 t 's @ (stack-used) ;
+
+Create stacks-max 0 , 0 , 0 , 0 , \ data return fp locals
+
+: umax! ( u addr -- )
+    \ atomically raise the contents of addr to at least u
+    BEGIN  2dup @ tuck u>  WHILE
+	    dup >r third swap third ?!@ r> =  UNTIL  2drop  EXIT  THEN
+    drop 2drop ;
+
+: stacks-observe ( task -- ) \ gforth-experimental
+    \G Take the stack usage of @i{task} into account for
+    \G @code{auto-stacksize4}.  Every task does this for itself when
+    \G it terminates.
+    stacks-used  stacks-max 3 cells + 4 0 DO  tuck umax! cell-  LOOP  drop ;
+
+:noname up@ stacks-observe  defers kill-task ; is kill-task
+
+: auto-stacksize ( u1 -- u2 )
+    \ twice the observed use, plus one page, in whole pages
+    2* pagesize + pagesize 1- + pagesize negate and ;
+
+: auto-stacksize4 ( -- u-data u-return u-fp u-locals ) \ gforth-experimental
+    \G Stack sizes derived from the largest stack use observed (with
+    \G @code{stacks-observe}) so far: twice that plus one page.  For
+    \G stacks without observations, the result is 0.
+    stacks-max 4 cells cell MEM+DO
+	I @ dup IF  auto-stacksize  THEN
+    LOOP ;
+
+Variable auto-stacks ( -- addr ) \ gforth-experimental
+\G If on, @code{newtask4} does not give any stack more than
+\G @code{auto-stacksize4}.  Observed maxima are kept in saved
+\G images, so you can measure a typical run, save the system, and
+\G use auto-stacks there.
+
+: limit-stack ( u1 u-auto -- u2 )
+    ?dup-IF  umin  THEN ;
+
+: limit-stacks ( u-data u-return u-fp u-locals -- u1 u2 u3 u4 )
+    {: d r f l :}  auto-stacksize4 {: d' r' f' l' :}
+    d d' limit-stack  r r' limit-stack  f f' limit-stack  l l' limit-stack ;
 
 : newtask4 ( u-data u-return u-fp u-locals -- task ) \ gforth-experimental
     \G creates @i{task} with data stack size @i{u-data}, return stack
     \G size @i{u-return}, FP stack size @i{u-fp} and locals stack size
     \G @i{u-locals}.
+    auto-stacks @ IF  limit-stacks  THEN
+    >r swap r> \ the engine wants data fp return locals
     gforth_create_thread >r
     throw-entry r@ udp @ throw-entry up@ - /string move
     word-pno-size chars r@ pagesize + over - dup holdbufptr r@ 's !
@@ -289,6 +350,29 @@ synonym sema semaphore
     { sema } try sema lock execute 0 restore sema unlock endtry throw ;
 synonym c-section critical-section
 
+\ the running tasks
+
+$Variable tasks$ \ cell array
+sema tasks-sema
+
+: task+ ( task -- )
+    [: {: w^ t :} t cell tasks$ $+! ;] tasks-sema c-section ;
+: task- ( task -- )
+    [: tasks$ $@ bounds ?DO
+	    dup I @ = IF  tasks$ I tasks$ $@ drop - cell $del  LEAVE  THEN
+	cell +LOOP  drop ;] tasks-sema c-section ;
+
+:noname defers thread-init  up@ task+ ; is thread-init
+:noname up@ task-  defers kill-task ; is kill-task
+host? [IF]  up@ task+  [THEN]
+
+: map-tasks ( ... xt -- ... ) \ gforth-experimental
+    \G Execute @i{xt} ( ... task -- ... ) for every running task,
+    \G including the main task.  Meanwhile, no task can start or
+    \G terminate, so @i{xt} must not wait for that.
+    [: {: xt :} tasks$ $@ bounds ?DO  I @ xt execute  cell +LOOP ;]
+    tasks-sema c-section ;
+
 : >pagealign-stack ( n addr -- n' ) \ gforth-experimental
     -1 under+ 1- pagesize negate mux 1+ ;
 : stacksize ( -- u ) \ gforth-experimental
@@ -297,7 +381,8 @@ synonym c-section critical-section
 : stacksize4 ( -- u-data u-return u-fp u-locals ) \ gforth-experimental
     \G Pushes the data, return, FP, and locals stack sizes of the main task.
     forthstart 8 cells + 4 cells cell MEM+DO  I @  LOOP
-    2>r >r  sp0 @ >pagealign-stack r> fp0 @ >pagealign-stack 2r> ;
+    2>r >r  sp0 @ >pagealign-stack r> fp0 @ >pagealign-stack 2r>
+    >r swap r> ; \ the image header has data fp return locals
 
 : execute-task ( xt -- task ) \ gforth-experimental
     \G Create a new task @var{task} with the same stack sizes as the
@@ -306,14 +391,20 @@ synonym c-section critical-section
     stacksize4 newtask4 tuck initiate ;
 
 : (stop) ( -- )
-    {: | w^ xt :} xt cell epiper @ read-file throw cell = IF
-	xt perform
+    {: | w^ xt :}  s" stop" trace-begin
+    xt cell epiper @ read-file  trace-end  throw cell = IF
+	s" event" trace-begin  xt ['] perform catch  trace-end  throw
     THEN ;
 : send-event ( xt task -- ) \ gforth-experimental
     \G Task IPC: send @var{xt} to @var{task}.  The xt is executed
     \G there.  Use a one-shot closure to pass parameters with the xt.
+    s" send-event" trace-instant
     >r {: w^ xt :} xt cell epipew r> 's @ write-file throw ;
 : event? ( -- flag )  epiper @ check_read 0> ;
+: event-depth ( task -- u ) \ gforth-experimental
+    \G @i{u} is the number of events sent to @i{task} that it has not
+    \G received yet.
+    epiper swap 's @ ?dup-IF  check_read 0 max cell/  ELSE  0  THEN ;
 
 : ?events ( -- ) \ gforth-experimental question-events
     \G Perform all event sequences in the current task's message
@@ -322,12 +413,14 @@ synonym c-section critical-section
 
 : stop ( -- ) \ gforth-experimental
 \G stops the current task, and waits for events (which may restart it)
-    (stop) ?events ;
+    event? 0= IF  obuf-flush  THEN  (stop) ?events ;
 : stop-ns ( timeout -- ) \ gforth-experimental
 \G Stop with timeout (in nanoseconds), better replacement for ms
-    epiper @ swap 0 1000000000 um/mod wait_read 0> IF  stop  THEN ;
+    obuf-flush  s" wait" trace-begin
+    epiper @ swap 0 1000000000 um/mod wait_read  trace-end  0> IF  stop  THEN ;
 : stop-dns ( dtimeout -- ) \ gforth-experimental
-    epiper @ -rot 1000000000 um/mod wait_read 0> IF  stop  THEN ;
+    obuf-flush  s" wait" trace-begin
+    epiper @ -rot 1000000000 um/mod wait_read  trace-end  0> IF  stop  THEN ;
 \G Stop with dtimeout (in nanoseconds), better replacement for ms
 
 : event-loop ( -- ) \ gforth-experimental
@@ -409,6 +502,7 @@ User keypollfds pollfd 2* cell- uallot drop
     epiper off
     epipew off
     wake# off
+    tasks$ off
 ; is 'image
 
 : prep-key ( -- )
@@ -418,7 +512,8 @@ User keypollfds pollfd 2* cell- uallot drop
 
 : thread-key ( -- key )
     prep-key
-    BEGIN  key? winch? @ or 0= WHILE  keypollfds 2 -1 poll drop
+    BEGIN  key? winch? @ or 0= WHILE
+	    s" key wait" trace-begin  keypollfds 2 -1 poll drop  trace-end
 	    keypollfds pollfd + revents w@ POLLIN and IF  ?events  THEN
     REPEAT  winch? @ IF  EINTR  ELSE  defers key-ior  THEN ;
 
@@ -428,6 +523,7 @@ User keypollfds pollfd 2* cell- uallot drop
     host? IF
 	pthread-id pthread_self epiper create_pipe
 	preserve key-ior  preserve deadline
+	up@ task+
     THEN ; is 'cold
 
 \ a simple test (not commented in)